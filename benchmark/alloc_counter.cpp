@@ -0,0 +1,36 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "alloc_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<std::size_t> allocations{ 0 }; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+} // namespace
+
+std::size_t alloc_counter::count()
+{
+  return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) // NOLINT(cppcoreguidelines-no-malloc)
+    return p;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p); // NOLINT(cppcoreguidelines-no-malloc)
+}
+
+void operator delete(void* p, std::size_t /*size*/) noexcept
+{
+  std::free(p); // NOLINT(cppcoreguidelines-no-malloc)
+}
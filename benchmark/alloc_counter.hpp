@@ -0,0 +1,26 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_BENCHMARK_ALLOC_COUNTER_HPP
+#define F16_BENCHMARK_ALLOC_COUNTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/// Number of heap allocations performed by the whole process
+/// (the global operator new is replaced in alloc_counter.cpp).
+namespace alloc_counter {
+
+std::size_t count();
+
+/// Average number of allocations per iteration, since a previous count.
+inline double per_iteration(std::size_t since, std::int64_t iterations)
+{
+  return iterations == 0 ? 0.0 : static_cast<double>(count() - since) / static_cast<double>(iterations);
+}
+
+} // namespace alloc_counter
+
+#endif // F16_BENCHMARK_ALLOC_COUNTER_HPP
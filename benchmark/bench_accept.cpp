@@ -0,0 +1,72 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Connection rate of f16 over the loopback interface: each client thread
+// opens a connection, sends a request, reads the reply and resets the
+// connection, in a loop. The server keeps one or more accept operations
+// outstanding, and takes the connections already queued by the kernel
+// in batches (or one at a time).
+
+#include "f16asio.hpp" // NB: the asio header must be included *before* iostream to avoid sanity check error
+#include <benchmark/benchmark.h>
+#include <string>
+#include "test_server.hpp"
+
+using namespace f16::http::server;
+using namespace f16::http::server::bench;
+
+namespace {
+
+/// Open a connection, GET /hello and close. Return the reply size.
+std::size_t one_shot_get(asio::io_context& ioc, const asio::ip::tcp::endpoint& endpoint, std::string& response)
+{
+  static const std::string request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+  asio::ip::tcp::socket socket(ioc);
+  socket.connect(endpoint);
+  asio::write(socket, asio::buffer(request));
+
+  response.clear();
+  const std::size_t header_size = asio::read_until(socket, asio::dynamic_buffer(response), "\r\n\r\n");
+  const auto pos = response.find("Content-Length: ");
+  const std::size_t content_length = (pos == std::string::npos || pos > header_size) ? 0 :
+    std::stoul(response.substr(pos + 16));
+  if (response.size() < header_size + content_length)
+    asio::read(socket, asio::dynamic_buffer(response), asio::transfer_exactly(header_size + content_length - response.size()));
+
+  // reset instead of a graceful close: no TIME_WAIT sockets pile up
+  socket.set_option(asio::socket_base::linger(true, 0));
+  socket.close();
+  return header_size + content_length;
+}
+
+template <std::size_t ConcurrentAccepts, std::size_t AcceptBatch>
+void BM_connection_rate(benchmark::State& state)
+{
+  const unsigned short port = static_cast<unsigned short>(7200 + ConcurrentAccepts * 2 + (AcceptBatch > 0 ? 1 : 0));
+  static test_server server(1, threading_model::per_worker, std::to_string(port), []() {
+    server_settings settings;
+    settings.concurrent_accepts = ConcurrentAccepts;
+    settings.accept_batch = AcceptBatch;
+    return settings;
+  }());
+
+  asio::io_context ioc;
+  const asio::ip::tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), port);
+  std::string response;
+  for (auto _ : state)
+    benchmark::DoNotOptimize(one_shot_get(ioc, endpoint, response));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+// one accept at a time (the old behavior)
+BENCHMARK_TEMPLATE(BM_connection_rate, 1, 0)->ThreadRange(1, 32)->UseRealTime();
+// several outstanding accepts
+BENCHMARK_TEMPLATE(BM_connection_rate, 4, 0)->ThreadRange(1, 32)->UseRealTime();
+// several outstanding accepts, draining the accept queue
+BENCHMARK_TEMPLATE(BM_connection_rate, 4, 16)->ThreadRange(1, 32)->UseRealTime();
@@ -0,0 +1,124 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Cost of serving a request with the handlers of the rest example:
+// written with f16::response_stream, and with a std::ostream (the
+// compatibility path, formatting through iostreams as before).
+// The last ones have a query: ignored, escaped, with repeated keys.
+
+#include "f16asio.hpp" // NB: the asio header must be included *before* iostream to avoid sanity check error
+#include <benchmark/benchmark.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "alloc_counter.hpp"
+#include "dynamic_content.hpp"
+#include "http_request.hpp"
+#include "reply.hpp"
+#include "request.hpp"
+#include "route_pattern.hpp"
+
+using namespace f16::http::server;
+
+namespace {
+
+struct rest_handler
+{
+  const char* name;
+  const char* location;
+  const char* path;
+  dynamic_content fast;
+  dynamic_content compat;
+};
+
+/// The handlers of src/examples/rest.cpp, in both forms.
+const std::vector<rest_handler>& rest_handlers()
+{
+  static const std::vector<rest_handler> handlers{
+    { "version", "/version", "/version",
+      get([](const request& /*req*/, f16::response_stream& os) { os << "1.0.0\n"; }),
+      get([](const request& /*req*/, std::ostream& os) { os << "1.0.0\n"; }) },
+    { "version_j", "/version_j", "/version_j",
+      get([](const request& /*req*/, f16::response_stream& os) { os << f16::json << R"({"version":"1.0.0"})"; }),
+      get([](const request& /*req*/, std::ostream& os) { os << R"({"version":"1.0.0"})"; }) },
+    { "hello/:name", "/hello/:name", "/hello/world",
+      get([](const request& req, f16::response_stream& os) { os << "Hello, " << req.resource("name") << "!\n"; }),
+      get([](const request& req, std::ostream& os) { os << "Hello, " << req.resource("name") << "!\n"; }) },
+    { "print?query", "/print", "/print?name=daniele&country=italy",
+      get([](const request& req, f16::response_stream& os) {
+        os << "Hi, " << req.query("name") << " from " << req.query("country") << "!\n";
+      }),
+      get([](const request& req, std::ostream& os) {
+        os << "Hi, " << req.query("name") << " from " << req.query("country") << "!\n";
+      }) },
+    { "greet/:name/:country", "/greet/:name/:country", "/greet/daniele/italy",
+      get([](const request& req, f16::response_stream& os) {
+        os << "Hi, " << req.resource("name") << " from " << req.resource("country") << "!\n";
+      }),
+      get([](const request& req, std::ostream& os) {
+        os << "Hi, " << req.resource("name") << " from " << req.resource("country") << "!\n";
+      }) },
+    { "numbers", "/numbers", "/numbers",
+      get([](const request& /*req*/, f16::response_stream& os) {
+        os << f16::json << R"({"id":)" << 42 << R"(,"count":)" << 1234567UL << R"(,"score":)" << 9.5 << '}';
+      }),
+      get([](const request& /*req*/, std::ostream& os) {
+        os << R"({"id":)" << 42 << R"(,"count":)" << 1234567UL << R"(,"score":)" << 9.5 << '}';
+      }) },
+    { "version?ignored", "/version", "/version?utm_source=newsletter&utm_medium=email&utm_campaign=launch",
+      get([](const request& /*req*/, f16::response_stream& os) { os << "1.0.0\n"; }),
+      get([](const request& /*req*/, std::ostream& os) { os << "1.0.0\n"; }) },
+    { "search?escaped&repeated", "/search", "/search?q=hello+big%20world&tag=a&tag=b&tag=c%2Bd",
+      get([](const request& req, f16::response_stream& os) {
+        os << "Searching " << req.query("q") << " in";
+        for (std::size_t i = 0; i < req.querystring.size(); ++i)
+          if (req.querystring[i].first == "tag")
+            os << ' ' << req.querystring[i].second;
+      }),
+      get([](const request& req, std::ostream& os) {
+        os << "Searching " << req.query("q") << " in";
+        for (std::size_t i = 0; i < req.querystring.size(); ++i)
+          if (req.querystring[i].first == "tag")
+            os << ' ' << req.querystring[i].second;
+      }) },
+  };
+  return handlers;
+}
+
+void serve(benchmark::State& state, bool fast)
+{
+  const auto& handler = rest_handlers().at(static_cast<std::size_t>(state.range(0)));
+  const dynamic_content& content = fast ? handler.fast : handler.compat;
+  const route_pattern location{ handler.location };
+  const std::string path = handler.path;
+  http_request http_req;
+
+  const auto allocs = alloc_counter::count();
+  for (auto _ : state)
+  {
+    reply rep;
+    content.serve_if_match(location, path, http_req, rep);
+    benchmark::DoNotOptimize(rep.content.data());
+  }
+
+  state.SetLabel(handler.name);
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs/op"] = alloc_counter::per_iteration(allocs, state.iterations());
+}
+
+void BM_dynamic_response_stream(benchmark::State& state)
+{
+  serve(state, true);
+}
+
+void BM_dynamic_ostream(benchmark::State& state)
+{
+  serve(state, false);
+}
+
+} // namespace
+
+BENCHMARK(BM_dynamic_response_stream)->DenseRange(0, 7);
+BENCHMARK(BM_dynamic_ostream)->DenseRange(0, 7);
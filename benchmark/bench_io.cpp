@@ -0,0 +1,87 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Small responses and large static files over the loopback interface,
+// to compare the I/O backends of asio: build once with the default
+// backend (epoll on Linux) and once with -DF16_IO_URING=ON, and compare
+// the runs (the backend is reported in the label of each benchmark).
+
+#include "f16asio.hpp" // NB: the asio header must be included *before* iostream to avoid sanity check error
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "static_content.hpp"
+#include "test_server.hpp"
+
+using namespace f16::http::server;
+using namespace f16::http::server::bench;
+
+namespace {
+
+/// A directory with a file of the given size, removed at the end of the run.
+class doc_root
+{
+public:
+  explicit doc_root(std::size_t file_size)
+    : path_(std::filesystem::temp_directory_path() / ("f16_bench_io_" + std::to_string(file_size)))
+  {
+    std::filesystem::create_directories(path_);
+    std::ofstream(path_ / "file.bin", std::ios::binary) << std::string(file_size, 'x');
+  }
+
+  doc_root(const doc_root&) = delete;
+  doc_root& operator=(const doc_root&) = delete;
+
+  ~doc_root()
+  {
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+  }
+
+  [[nodiscard]] std::string path() const { return path_.string(); }
+
+private:
+  std::filesystem::path path_;
+};
+
+void BM_small_response(benchmark::State& state)
+{
+  static test_server server(1, threading_model::per_worker, "7250");
+
+  test_client client("7250");
+  std::size_t bytes = 0;
+  for (auto _ : state)
+    bytes += client.get("/hello");
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  state.SetLabel(f16::io_backend);
+}
+
+template <std::size_t FileSize>
+void BM_static_file(benchmark::State& state)
+{
+  const std::string port = std::to_string(7251 + FileSize % 97);
+  static const doc_root root(FileSize);
+  static test_server server(1, threading_model::per_worker, port, {}, [](path_router& router) {
+    router.add("/files", static_content(root.path()));
+  });
+
+  test_client client(port);
+  std::size_t bytes = 0;
+  for (auto _ : state)
+    bytes += client.get("/files/file.bin");
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  state.SetLabel(f16::io_backend);
+}
+
+} // namespace
+
+BENCHMARK(BM_small_response)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_static_file, 64 * 1024)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_static_file, 1024 * 1024)->ThreadRange(1, 16)->UseRealTime();
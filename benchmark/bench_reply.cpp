@@ -0,0 +1,89 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Cost of building a reply and of converting it into the buffers
+// to write, for the usual shapes: an error page, a small JSON document
+// and a large file.
+
+#include "f16asio.hpp" // NB: the asio header must be included *before* iostream to avoid sanity check error
+#include <benchmark/benchmark.h>
+#include <string>
+#include "alloc_counter.hpp"
+#include "reply.hpp"
+
+using namespace f16::http::server;
+
+namespace {
+
+reply make_reply(std::int64_t shape)
+{
+  switch (shape)
+  {
+  case 0:
+    return reply::stock_reply(reply::not_found);
+  case 1:
+  {
+    reply rep;
+    rep.status = reply::ok;
+    rep.content = R"({"id":42,"name":"f16","tags":["http","server","c++"],"active":true,"score":9.5})";
+    rep.headers.push_back({ "Content-Length", std::to_string(rep.content.size()) });
+    rep.headers.push_back({ "Content-Type", "application/json" });
+    rep.headers.push_back({ "Connection", "keep-alive" });
+    return rep;
+  }
+  default:
+  {
+    reply rep;
+    rep.status = reply::ok;
+    rep.content.assign(std::size_t{ 64 } * 1024, 'x');
+    rep.headers.push_back({ "Content-Length", std::to_string(rep.content.size()) });
+    rep.headers.push_back({ "Content-Type", "application/octet-stream" });
+    rep.headers.push_back({ "Last-Modified", "Wed, 21 Oct 2015 07:28:00 GMT" });
+    rep.headers.push_back({ "ETag", "\"33a64df551425fcc55e4d42a148795d9f25f89d4\"" });
+    rep.headers.push_back({ "Connection", "keep-alive" });
+    return rep;
+  }
+  }
+}
+
+const char* shape_name(std::int64_t shape)
+{
+  switch (shape)
+  {
+  case 0: return "stock 404";
+  case 1: return "small json";
+  default: return "64KB file";
+  }
+}
+
+void BM_reply_build(benchmark::State& state)
+{
+  const auto allocs = alloc_counter::count();
+  for (auto _ : state)
+  {
+    reply rep = make_reply(state.range(0));
+    benchmark::DoNotOptimize(rep.content.data());
+  }
+  state.SetLabel(shape_name(state.range(0)));
+  state.counters["allocs/op"] = alloc_counter::per_iteration(allocs, state.iterations());
+}
+
+void BM_reply_to_buffers(benchmark::State& state)
+{
+  reply rep = make_reply(state.range(0));
+  const auto allocs = alloc_counter::count();
+  for (auto _ : state)
+  {
+    auto buffers = rep.to_buffers();
+    benchmark::DoNotOptimize(buffers.data());
+  }
+  state.SetLabel(shape_name(state.range(0)));
+  state.counters["allocs/op"] = alloc_counter::per_iteration(allocs, state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_reply_build)->DenseRange(0, 2);
+BENCHMARK(BM_reply_to_buffers)->DenseRange(0, 2);
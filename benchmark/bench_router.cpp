@@ -0,0 +1,107 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Routing cost of path_router, with route tables of growing size:
+// a request matching a route with a path parameter (also with the route
+// cache), one matching a long route with two parameters, and one matching
+// no route at all (404).
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include "alloc_counter.hpp"
+#include "http_request.hpp"
+#include "path_router.hpp"
+#include "reply.hpp"
+#include "request.hpp"
+#include "request_parser.hpp"
+
+using namespace f16::http::server;
+
+namespace {
+
+/// A router with the given number of REST resources ("/api/v1/resource<i>/:id").
+path_router make_router(std::int64_t routes)
+{
+  path_router router;
+  for (std::int64_t i = 0; i < routes; ++i)
+  {
+    router.add("/api/v1/resource" + std::to_string(i) + "/:id",
+      get([](const request& req, f16::response_stream& out) { out << "item " << req.resource("id"); }));
+  }
+  return router;
+}
+
+void route(benchmark::State& state, path_router& router, const std::string& head, std::size_t cache = 0)
+{
+  router.enable_cache(cache);
+  request_parser parser;
+  http_request req;
+  parser.parse(req, head.data(), head.data() + head.size());
+
+  const auto allocs = alloc_counter::count();
+  for (auto _ : state)
+  {
+    reply rep;
+    router(req, rep);
+    benchmark::DoNotOptimize(rep.content.data());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs/op"] = alloc_counter::per_iteration(allocs, state.iterations());
+  if (cache != 0)
+    state.counters["hit rate"] = router.cache_stats().hit_rate();
+}
+
+void BM_path_router_match(benchmark::State& state)
+{
+  // the route added in the middle of the table
+  const std::string head =
+    "GET /api/v1/resource" + std::to_string(state.range(0) / 2) + "/42?fields=name HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+  path_router router = make_router(state.range(0));
+  route(state, router, head);
+}
+
+void BM_path_router_match_long(benchmark::State& state)
+{
+  // a path longer than the small string buffer: it's not copied to be
+  // decoded, so the reply is the only allocation
+  path_router router = make_router(state.range(0));
+  router.add("/api/users/:id/orders/:order",
+    get([](const request& req, f16::response_stream& out) { out << "order " << req.resource("order"); }));
+  const std::string head =
+    "GET /api/users/1234567/orders/8901 HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+  route(state, router, head);
+}
+
+void BM_path_router_match_cached(benchmark::State& state)
+{
+  const std::string head =
+    "GET /api/v1/resource" + std::to_string(state.range(0) / 2) + "/42?fields=name HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+  path_router router = make_router(state.range(0));
+  route(state, router, head, 256);
+}
+
+void BM_path_router_not_found(benchmark::State& state)
+{
+  const std::string head =
+    "GET /api/v2/missing/42 HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+  path_router router = make_router(state.range(0));
+  route(state, router, head);
+}
+
+} // namespace
+
+BENCHMARK(BM_path_router_match)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_path_router_match_long)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_path_router_match_cached)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_path_router_not_found)->RangeMultiplier(10)->Range(1, 1000);
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// End to end throughput of f16 over the loopback interface.
+// The same server is run with one io_context, with an io_context_pool
+// (one io_context and SO_REUSEPORT acceptor for each worker) and with one
+// io_context shared by the workers (a strand for each connection), while
+// a growing number of client threads send keep-alive requests.
+// The latency of the callback and coroutine connections is compared
+// with a single client, also while other clients call a handler that
+// blocks, run on the I/O thread or on the worker pool.
+
+#include "f16asio.hpp" // NB: the asio header must be included *before* iostream to avoid sanity check error
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "alloc_counter.hpp"
+#include "test_server.hpp"
+
+using namespace f16::http::server;
+using namespace f16::http::server::bench;
+
+namespace {
+
+template <std::size_t Workers, threading_model Model>
+void BM_keep_alive_throughput(benchmark::State& state)
+{
+  const std::string port = std::to_string(7100 + Workers + (Model == threading_model::shared ? 50 : 0));
+  static test_server server(Workers, Model, port);
+
+  test_client client(port);
+  client.get("/hello"); // warm up the connection
+  std::size_t bytes = 0;
+  const auto allocs = alloc_counter::count();
+  for (auto _ : state)
+    bytes += client.get("/hello");
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  // process-wide: the allocations of all the client threads (and of the server) are included
+  state.counters["allocs/req"] = benchmark::Counter(
+    static_cast<double>(alloc_counter::count() - allocs) / static_cast<double>(state.iterations() * state.threads()),
+    benchmark::Counter::kAvgThreads);
+}
+
+/// Latency of a single client, with the callback or the coroutine connections.
+template <bool Coroutine>
+void BM_keep_alive_latency(benchmark::State& state)
+{
+  const std::string port = Coroutine ? "7180" : "7181";
+  static test_server server(1, threading_model::per_worker, port, []() {
+    server_settings settings;
+    settings.coroutine_connections = Coroutine;
+    return settings;
+  }());
+
+  test_client client(port);
+  client.get("/hello"); // warm up the connection
+  const auto allocs = alloc_counter::count();
+  for (auto _ : state)
+    benchmark::DoNotOptimize(client.get("/hello"));
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs/req"] = benchmark::Counter(
+    static_cast<double>(alloc_counter::count() - allocs) / static_cast<double>(state.iterations()));
+}
+
+/// Latency of a single client while 4 other clients call a handler blocking
+/// for 1 ms, run on the I/O thread (inline) or on the worker pool (offloaded).
+template <bool Offload>
+void BM_latency_with_blocking_handler(benchmark::State& state)
+{
+  const std::string port = Offload ? "7182" : "7183";
+  static test_server server(1, threading_model::per_worker, port, []() {
+    server_settings settings;
+    settings.worker_threads = Offload ? 4 : 0;
+    return settings;
+  }(),
+  [](path_router& router) {
+    router.add("/blocking", get([](const request& /*req*/, f16::response_stream& os) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      os << "done";
+    }).offload());
+  });
+
+  std::atomic<bool> stop{ false };
+  std::vector<std::thread> blockers;
+  for (int i = 0; i < 4; ++i)
+  {
+    blockers.emplace_back([&stop, &port]() {
+      test_client blocker(port);
+      while (!stop)
+        blocker.get("/blocking");
+    });
+  }
+
+  test_client client(port);
+  client.get("/hello"); // warm up the connection
+  for (auto _ : state)
+    benchmark::DoNotOptimize(client.get("/hello"));
+
+  stop = true;
+  for (auto& t : blockers)
+    t.join();
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+// callback connections
+BENCHMARK_TEMPLATE(BM_keep_alive_latency, false)->UseRealTime();
+#if defined(ASIO_HAS_CO_AWAIT)
+// coroutine connections (C++20)
+BENCHMARK_TEMPLATE(BM_keep_alive_latency, true)->UseRealTime();
+#endif
+
+// a blocking handler run inline, and on the worker pool
+BENCHMARK_TEMPLATE(BM_latency_with_blocking_handler, false)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_latency_with_blocking_handler, true)->UseRealTime();
+
+// single io_context (the f16 server default)
+BENCHMARK_TEMPLATE(BM_keep_alive_throughput, 1, threading_model::per_worker)->ThreadRange(1, 16)->UseRealTime();
+// one io_context for each worker
+BENCHMARK_TEMPLATE(BM_keep_alive_throughput, 4, threading_model::per_worker)->ThreadRange(1, 16)->UseRealTime();
+// one io_context shared by all the workers
+BENCHMARK_TEMPLATE(BM_keep_alive_throughput, 4, threading_model::shared)->ThreadRange(1, 16)->UseRealTime();
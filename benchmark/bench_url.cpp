@@ -0,0 +1,53 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Decoding of request paths by url_decode: a plain path, a path with
+// a few escapes and a fully escaped one.
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <string>
+#include "alloc_counter.hpp"
+#include "url.hpp"
+
+using namespace f16::http::server;
+
+namespace {
+
+struct sample
+{
+  const char* name;
+  const char* uri;
+};
+
+const std::array<sample, 3> uris{ { // NOLINT
+  { "plain", "/assets/javascript/application-5e6b2c8d9f.min.js?version=2024.08.20" },
+  { "some escapes", "/files/My%20Documents/report%202024%20(final).pdf?sort=name+asc" },
+  { "all escapes", "/%E4%BD%A0%E5%A5%BD/%E4%B8%96%E7%95%8C/%F0%9F%9A%80%F0%9F%9A%80%F0%9F%9A%80" },
+} };
+
+void BM_url_decode(benchmark::State& state)
+{
+  const sample& s = uris.at(static_cast<std::size_t>(state.range(0)));
+  const std::string_view in{ s.uri };
+  std::string out;
+  out.reserve(in.size());
+
+  const auto allocs = alloc_counter::count();
+  for (auto _ : state)
+  {
+    out.clear();
+    benchmark::DoNotOptimize(url_decode(in, out));
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetLabel(s.name);
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(in.size()));
+  state.counters["allocs/op"] = alloc_counter::per_iteration(allocs, state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_url_decode)->DenseRange(0, static_cast<int>(uris.size()) - 1);
@@ -0,0 +1,98 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_BENCHMARK_TEST_SERVER_HPP
+#define F16_BENCHMARK_TEST_SERVER_HPP
+
+#include "f16asio.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "dynamic_content.hpp"
+#include "http_server.hpp"
+#include "io_context_pool.hpp"
+#include "request.hpp"
+
+namespace f16::http::server::bench {
+
+/// A server running on its own threads for the whole benchmark run.
+/// It serves /hello, plus the routes added by add_routes.
+class test_server
+{
+public:
+  test_server(std::size_t workers, threading_model model, const std::string& port, server_settings settings = {},
+      const std::function<void(path_router&)>& add_routes = {})
+    : pool_(workers, model)
+  {
+    settings.max_keep_alive_requests = 0; // the test clients never reconnect
+    settings.reuse_port = pool_.size() > 1;
+    settings.strand_per_connection = pool_.size() == 1 && pool_.threads() > 1;
+    for (std::size_t i = 0; i < pool_.size(); ++i)
+    {
+      auto server = std::make_unique<http_server>(pool_[i], settings);
+      path_router router;
+      router.add("/hello", get([](const request& /*req*/, std::ostream& os) { os << "Hello, world!\n"; }));
+      if (add_routes)
+        add_routes(router);
+      server->set(std::move(router));
+      server->listen(port, "127.0.0.1");
+      servers_.push_back(std::move(server));
+    }
+    runner_ = std::thread([this]() { pool_.run(); });
+  }
+
+  test_server(const test_server&) = delete;
+  test_server& operator=(const test_server&) = delete;
+
+  ~test_server()
+  {
+    pool_.stop();
+    runner_.join();
+  }
+
+private:
+  io_context_pool pool_;
+  std::vector<std::unique_ptr<http_server>> servers_;
+  std::thread runner_;
+};
+
+/// A blocking client sending one request at a time on a persistent connection.
+class test_client
+{
+public:
+  explicit test_client(const std::string& port) : socket_(ioc_)
+  {
+    asio::ip::tcp::resolver resolver(ioc_);
+    asio::connect(socket_, resolver.resolve("127.0.0.1", port));
+  }
+
+  /// Send a GET request and read the whole reply. Return the reply size.
+  std::size_t get(const std::string& target)
+  {
+    request_ = "GET " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    asio::write(socket_, asio::buffer(request_));
+
+    const std::size_t header_size = asio::read_until(socket_, asio::dynamic_buffer(response_), "\r\n\r\n");
+    const auto pos = response_.find("Content-Length: ");
+    const std::size_t content_length = (pos == std::string::npos || pos > header_size) ? 0 :
+      std::stoul(response_.substr(pos + 16));
+    if (response_.size() < header_size + content_length)
+      asio::read(socket_, asio::dynamic_buffer(response_), asio::transfer_exactly(header_size + content_length - response_.size()));
+    response_.erase(0, header_size + content_length);
+    return header_size + content_length;
+  }
+
+private:
+  asio::io_context ioc_;
+  asio::ip::tcp::socket socket_;
+  std::string request_;
+  std::string response_;
+};
+
+} // namespace f16::http::server::bench
+
+#endif // F16_BENCHMARK_TEST_SERVER_HPP
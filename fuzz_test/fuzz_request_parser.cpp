@@ -13,10 +13,28 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
 {
   using namespace f16::http::server;
 
+  // the whole input at once: long runs scanned with SIMD
   request_parser grammar;
   http_request req;
   const std::string input(reinterpret_cast<const char *>(data), size); // NOLINT
-  grammar.parse(req, input.begin(), input.end());
+  const auto result = grammar.parse(req, input.begin(), input.end());
+
+  // one byte at a time: state machine only
+  request_parser slow_grammar;
+  http_request slow_req;
+  auto slow_result = std::make_tuple(request_parser::indeterminate, input.begin());
+  for (auto it = input.begin(); it != input.end() && std::get<0>(slow_result) == request_parser::indeterminate; ++it)
+    slow_result = slow_grammar.parse(slow_req, it, it + 1);
+
+  // both paths must agree
+  if (std::get<0>(result) != std::get<0>(slow_result)
+      || std::get<1>(result) != std::get<1>(slow_result)
+      || req.method != slow_req.method || req.uri != slow_req.uri
+      || req.headers.size() != slow_req.headers.size())
+    __builtin_trap();
+  for (std::size_t i = 0; i < req.headers.size(); ++i)
+    if (req.headers[i].name != slow_req.headers[i].name || req.headers[i].value != slow_req.headers[i].value)
+      __builtin_trap();
 
   return 0;
 }
@@ -40,7 +40,7 @@ int main(int /*argc*/, const char** /*argv*/)
     http_server.set(
       [](const http_request& req, reply& res)
       {
-        std::string host = req.get_header("host");
+        std::string host{req.get_header(known_header::host)};
         if (host.empty()) // no host header
         {
           res = reply::stock_reply(reply::bad_request); // 400
@@ -50,7 +50,7 @@ int main(int /*argc*/, const char** /*argv*/)
           if (auto pos = host.find(':'); pos != std::string::npos)
             host.erase(pos); // Erases everything after the ':' character
           res = reply::stock_reply(reply::moved_permanently); // 301
-          res.headers.push_back({"Location", "https://" + host + ":7000" + req.uri});
+          res.headers.push_back({"Location", "https://" + host + ":7000" + std::string(req.uri)});
         }
       }
     );
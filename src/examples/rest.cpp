@@ -4,9 +4,11 @@
 // file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include "f16asio.hpp" // NB: the asio header must be included *before* iostream to avoid sanity check error
+#include <chrono>
 #include <iostream>
+#include <thread>
 #include "http_server.hpp"
-#include "dynamic_content.hpp" // get, post, put
+#include "dynamic_content.hpp" // get, post, put, get_async
 #include "request.hpp"
 
 int main()
@@ -16,7 +18,9 @@ int main()
     asio::io_context ioc;
 
     using namespace f16::http::server;
-    http_server server(ioc);
+    server_settings settings;
+    settings.worker_threads = 2; // for the offloaded handlers
+    http_server server(ioc, settings);
 
     path_router router;
     // GET <ip>/version
@@ -43,6 +47,47 @@ int main()
         os << "ok";
       })
     );
+    // GET <ip>/count/<n> (the content is sent a chunk at a time, as it's produced)
+    router.add("/count/:n", get([](const request& req, f16::response_stream& os) {
+        auto remaining = std::make_shared<long>(std::atol(req.resource("n").c_str()));
+        os.stream([remaining](std::string& chunk) {
+          if (*remaining <= 0)
+            return false;
+          chunk = std::to_string((*remaining)--) + '\n';
+          return true;
+        });
+      })
+    );
+    // POST <ip>/echo (the body is collected in the request)
+    router.add("/echo", post([](const request& req, std::ostream& os) { os << req.body(); }));
+    // POST <ip>/upload (the body is consumed while it arrives)
+    router.add("/upload", post_stream([](const request& /*req*/) {
+        auto size = std::make_shared<std::size_t>(0);
+        return body_stream{
+          [size](std::string_view data) { *size += data.size(); },
+          [size](f16::response_stream& os) { os << "Received " << *size << " bytes\n"; }
+        };
+      })
+    );
+
+    // GET <ip>/report (a slow handler: it runs on a worker thread, so that it doesn't stall the other requests)
+    router.add("/report", get([](const request& /*req*/, f16::response_stream& os) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        os << "report ready\n";
+      }).offload()
+    );
+    // GET <ip>/later/<ms> (the response is sent by a timer: the thread is free meanwhile)
+    router.add("/later/:ms", get_async([](const request& req, f16::async_response res) {
+        auto timer = std::make_shared<asio::steady_timer>(res.get_executor(), std::chrono::milliseconds(std::atol(req.resource("ms").c_str())));
+        timer->async_wait([timer, res](const asio::error_code& /*ec*/) {
+          res << "sent later\n";
+          res.send();
+        });
+      })
+    );
+
+    // remember the resources of the last 256 paths
+    router.enable_cache(256);
 
     server.set(std::move(router));
 
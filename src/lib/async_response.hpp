@@ -0,0 +1,154 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_ASYNC_RESPONSE_HPP
+#define F16_HTTP_ASYNC_RESPONSE_HPP
+
+#include "f16asio.hpp"
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "reply.hpp"
+#include "request.hpp"
+#include "response_stream.hpp"
+
+namespace f16 {
+class async_response;
+} // namespace f16
+
+namespace f16::http::server {
+
+/// A handler completing its response after it has returned (see get_async).
+using async_handler = std::function<void(const request& req, f16::async_response res)>;
+
+/// The state of a reply produced by an asynchronous handler, shared by the
+/// copies of its async_response. The connection starts the handler and
+/// waits for the reply, without blocking its thread.
+class async_reply : public std::enable_shared_from_this<async_reply>
+{
+public:
+  /// The request must stay valid until the reply is ready (the connection
+  /// doesn't touch it meanwhile): the values of the path parameters and
+  /// the query are copied.
+  async_reply(const async_handler& handler, const http_request& req, const path_params& params, std::string_view query);
+
+  async_reply(const async_reply&) = delete;
+  async_reply& operator=(const async_reply&) = delete;
+
+  /// Send "500 Internal Server Error", if the handler didn't send the response.
+  ~async_reply();
+
+  /// The request passed to the handler.
+  request& get_request() { return req_; }
+
+  /// Call the handler: ready is called once, with the reply, when the handler
+  /// sends the response (from its thread, maybe during this call).
+  void start(asio::any_io_executor executor, std::function<void(reply)> ready);
+
+  /// The response written by the handler.
+  response_stream& stream() { return stream_; }
+
+  /// Pass the response to the connection (only the first call counts).
+  void send();
+
+  [[nodiscard]] const asio::any_io_executor& get_executor() const { return executor_; }
+
+private:
+  const async_handler& handler_;
+  request req_;
+  std::string values_; // the storage of the values of req_.resources and of req_.querystring
+  response_stream stream_;
+  asio::any_io_executor executor_;
+  std::function<void(reply)> ready_;
+  std::atomic<bool> sent_{ false };
+};
+
+} // namespace f16::http::server
+
+namespace f16 {
+
+/// The response of an asynchronous handler (see get_async). It's written
+/// as a response_stream, and it's sent when send() is called, from any
+/// thread. The copies refer to the same response: when the last one goes
+/// away without send(), "500 Internal Server Error" is sent.
+class async_response
+{
+public:
+  explicit async_response(std::shared_ptr<http::server::async_reply> _state) : state(std::move(_state)) {}
+
+  /// The content and the properties of the response (see response_stream).
+  [[nodiscard]] response_stream& stream() const { return state->stream(); }
+
+  template <typename T>
+  const async_response& operator<<(const T& value) const
+  {
+    state->stream() << value;
+    return *this;
+  }
+
+  const async_response& operator<<(response_stream& (*f)(response_stream&)) const
+  {
+    state->stream() << f;
+    return *this;
+  }
+
+  const async_response& operator<<(std::ostream& (*f)(std::ostream&)) const
+  {
+    state->stream() << f;
+    return *this;
+  }
+
+  /// Send the response: what has been written is final.
+  void send() const { state->send(); }
+
+  /// The executor of the connection, that can run the asynchronous
+  /// operations of the handler (e.g., its timers).
+  [[nodiscard]] const asio::any_io_executor& get_executor() const { return state->get_executor(); }
+
+private:
+  std::shared_ptr<http::server::async_reply> state;
+};
+
+} // namespace f16
+
+namespace f16::http::server {
+
+/// The async_handler calling handler. With C++20, handler can be a coroutine
+/// returning asio::awaitable<void>: it runs on the executor of the connection,
+/// and the response is sent when it returns (if it wasn't sent before).
+template <typename Handler>
+async_handler make_async_handler(Handler handler)
+{
+#if defined(ASIO_HAS_CO_AWAIT)
+  if constexpr (std::is_same_v<std::invoke_result_t<Handler&, const request&, f16::async_response>, asio::awaitable<void>>)
+  {
+    return [handler = std::move(handler)](const request& req, f16::async_response res) {
+      auto executor = res.get_executor();
+      asio::co_spawn(executor, handler(req, res),
+          [res](std::exception_ptr e)
+          {
+            // as the other handlers, let the exceptions reach the io_context
+            if (e)
+              std::rethrow_exception(e);
+            res.send();
+          });
+    };
+  }
+  else
+#endif
+  {
+    return async_handler(std::move(handler));
+  }
+}
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_ASYNC_RESPONSE_HPP
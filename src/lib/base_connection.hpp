@@ -6,13 +6,29 @@
 #ifndef F16_HTTP_BASE_CONNECTION_HPP
 #define F16_HTTP_BASE_CONNECTION_HPP
 
+#include <algorithm>
 #include <array>
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "body_parser.hpp"
+#include "body_reader.hpp"
 #include "connection_manager.hpp"
+#include "handler_allocator.hpp"
 #include "http_request.hpp"
 #include "request_parser.hpp"
 #include "request_handler.hpp"
 #include "reply.hpp"
 #include "connection.hpp"
+#include "server_settings.hpp"
+#include "timer_wheel.hpp"
+#include "worker_pool.hpp"
 
 namespace f16::http::server {
 
@@ -25,77 +41,689 @@ public:
 
   void stop() override
   {
-    socket_.lowest_layer().close();
+    timer_.cancel();
+    socket_->lowest_layer().close();
+    // a stream waiting for its producer gives up
+    chunk_waiter_ = nullptr;
   }
 
 protected:
 
-  base_connection(SocketType socket, connection_manager& manager, request_handler& handler)
+  base_connection(SocketType socket, connection_manager& manager, request_handler& handler,
+      const server_settings& settings, timer_wheel& timers)
     : socket_(std::move(socket)),
       connection_manager_(manager),
       request_handler_(handler),
+      settings_(settings),
+      timer_(timers, [this]() { on_timer_expired(); }),
       buffer_{},
-      request_{},
-      reply_{}
+      request_{}
   {
   }
 
+  /// What the connection is waiting for, to choose the timeout.
+  enum class timeout_phase
+  {
+    none,
+    header,
+    body,
+    write,
+    keep_alive,
+    handler
+  };
+
+  /// (Re)arm the timer of the connection for the given phase.
+  /// The header and body timeouts are not re-armed while the same request is
+  /// arriving, so that a client sending a byte at a time cannot hold the connection.
+  void set_timeout(timeout_phase phase)
+  {
+    if (phase == phase_ && (phase == timeout_phase::header || phase == timeout_phase::body))
+      return;
+    phase_ = phase;
+
+    std::chrono::milliseconds timeout{ 0 };
+    switch (phase)
+    {
+      case timeout_phase::header: timeout = settings_.header_timeout; break;
+      case timeout_phase::body: timeout = settings_.body_timeout; break;
+      case timeout_phase::write: timeout = settings_.write_timeout; break;
+      case timeout_phase::keep_alive: timeout = settings_.keep_alive_timeout; break;
+      case timeout_phase::handler: timeout = settings_.handler_timeout; break;
+      case timeout_phase::none: break;
+    }
+    if (timeout.count() > 0)
+      timer_.arm(timeout);
+    else
+      timer_.cancel();
+  }
+
   void do_read()
   {
     auto self{this->shared_from_this()};
-    socket_.async_read_some(asio::buffer(buffer_),
+    socket_->async_read_some(read_buffer(),
+        make_custom_alloc_handler(read_memory_,
         [this, self](std::error_code ec, std::size_t bytes_transferred)
         {
           if (!ec)
           {
-            request_parser::result_type result = request_parser::bad;
-            std::tie(result, std::ignore) = request_parser_.parse(
-                request_, buffer_.begin(), buffer_.begin() + bytes_transferred);
-
-            if (result == request_parser::good)
-            {
-              request_handler_.handle_request(request_, reply_);
-              do_write();
-            }
-            else if (result == request_parser::bad)
-            {
-              reply_ = reply::stock_reply(reply::bad_request);
-              do_write();
-            }
-            else
-            {
-              do_read();
-            }
+            buffer_end_ += bytes_transferred;
+            process_buffer();
           }
           else if (ec != asio::error::operation_aborted)
           {
             connection_manager_.stop(this->shared_from_this());
           }
+        }));
+  }
+
+  /// Parse all the requests available in the buffer (the client can pipeline
+  /// several of them), then send back all the replies at once.
+  void process_buffer()
+  {
+    parse_requests();
+
+    if (pending_ != nullptr)
+    {
+      // go on when the reply of the request is ready
+      wait_pending([self = this->shared_from_this()]() { self->process_buffer(); });
+      return;
+    }
+
+    if (replies_.empty())
+    {
+      set_read_timeout();
+      do_read();
+    }
+    else
+    {
+      do_write();
+    }
+  }
+
+  /// Make room for the next read in buffer_, and return the space to read into.
+  /// The request being received refers to its data in buffer_: the data
+  /// received so far (or its head, while the body is arriving) is kept,
+  /// moving it at the start of buffer_.
+  asio::mutable_buffer read_buffer()
+  {
+    std::size_t keep_end = 0;
+    if (request_started_)
+      keep_end = buffer_end_;
+    else if (reading_body_)
+      keep_end = head_end_;
+
+    if (keep_end == 0)
+    {
+      buffer_begin_ = 0;
+      buffer_end_ = 0;
+    }
+    else
+    {
+      const auto offset = static_cast<std::ptrdiff_t>(request_start_);
+      if (offset != 0)
+      {
+        std::copy(buffer_.begin() + offset, buffer_.begin() + static_cast<std::ptrdiff_t>(keep_end), buffer_.begin());
+        request_.relocate(-offset);
+      }
+      keep_end -= request_start_;
+      head_end_ = reading_body_ ? keep_end : 0;
+      request_start_ = 0;
+      // the body already parsed is not needed any more
+      buffer_begin_ = keep_end;
+      buffer_end_ = keep_end;
+    }
+    return asio::buffer(buffer_.data() + buffer_end_, buffer_.size() - buffer_end_);
+  }
+
+  /// Tell whether the head of the request being received fills buffer_.
+  [[nodiscard]] bool head_too_large(std::size_t head_end) const
+  {
+    return head_end - request_start_ >= buffer_.size();
+  }
+
+  /// Parse all the requests available in the buffer, queuing their replies.
+  /// The parsing stops at a request whose reply is not ready (see wait_pending).
+  void parse_requests()
+  {
+    while (buffer_begin_ != buffer_end_ && pending_ == nullptr)
+    {
+      if (reading_body_)
+      {
+        if (!parse_body())
+          break;
+        continue;
+      }
+
+      if (!request_started_)
+        request_start_ = buffer_begin_;
+      const char* data = buffer_.data();
+      auto [result, consumed] = request_parser_.parse(request_, data + buffer_begin_, data + buffer_end_);
+      buffer_begin_ = static_cast<std::size_t>(consumed - data);
+
+      if (result == request_parser::good)
+      {
+        request_started_ = false;
+        ++requests_served_;
+        keep_alive_ = settings_.keep_alive && request_.keep_alive()
+          && (settings_.max_keep_alive_requests == 0 || requests_served_ < settings_.max_keep_alive_requests);
+        if (!start_body())
+          break;
+      }
+      else if (result == request_parser::bad)
+      {
+        queue_error(reply::bad_request);
+        break;
+      }
+      else
+      {
+        // the whole buffer belongs to a request not complete yet
+        request_started_ = true;
+        if (head_too_large(buffer_end_))
+          queue_error(reply::request_header_fields_too_large);
+      }
+    }
+  }
+
+  /// Get ready for the body of the request whose headers have been parsed.
+  /// Return false when no more requests must be parsed on this connection.
+  bool start_body()
+  {
+    switch (body_parser_.start(request_, settings_.max_body_size))
+    {
+      case body_parser::good:
+        // no body
+        complete_request();
+        return keep_alive_;
+      case body_parser::too_large:
+        // don't wait for the body
+        queue_error(reply::payload_too_large);
+        return false;
+      case body_parser::indeterminate:
+        // there must be room for the body after the head
+        if (head_too_large(buffer_begin_))
+        {
+          queue_error(reply::request_header_fields_too_large);
+          return false;
+        }
+        body_reader_ = request_handler_.open_body(request_);
+        reading_body_ = true;
+        head_end_ = buffer_begin_;
+        // the client waits for the go-ahead before sending the body
+        // (a body too large has already been refused)
+        if (buffer_begin_ == buffer_end_ && request_.expects_continue())
+          replies_.emplace_back().status = reply::continue_;
+        return true;
+      case body_parser::bad:
+      default:
+        queue_error(reply::bad_request);
+        return false;
+    }
+  }
+
+  /// Pass the body data available in the buffer to the body_reader of the
+  /// request (or collect it in the request, when there is no body_reader).
+  /// Return false when no more requests must be parsed on this connection.
+  bool parse_body()
+  {
+    const char* data = buffer_.data();
+    auto [result, consumed] = body_parser_.parse(data + buffer_begin_, data + buffer_end_,
+        [this](const char* chunk, std::size_t size)
+        {
+          if (body_reader_)
+            body_reader_->on_data(chunk, size);
+          else
+            request_.body.append(chunk, size);
+        });
+    buffer_begin_ = static_cast<std::size_t>(consumed - data);
+
+    switch (result)
+    {
+      case body_parser::good:
+        complete_request();
+        return keep_alive_;
+      case body_parser::indeterminate:
+        return true;
+      case body_parser::too_large:
+        queue_error(reply::payload_too_large);
+        return false;
+      case body_parser::bad:
+      default:
+        queue_error(reply::bad_request);
+        return false;
+    }
+  }
+
+  /// Handle the request completely received, queuing its reply.
+  void complete_request()
+  {
+    phase_ = timeout_phase::none;
+    reply& rep = replies_.emplace_back();
+    if (body_reader_)
+    {
+      body_reader_->on_complete(rep);
+    }
+    else if (!request_handler_.try_handle_request(request_, rep) || rep.async)
+    {
+      // the request and the buffer are left untouched until the reply is ready
+      pending_ = &rep;
+      return;
+    }
+    finish_request(rep);
+  }
+
+  /// Get the reply of the pending request, produced by a worker thread
+  /// (see dynamic_content::offload) or by an asynchronous handler (see
+  /// get_async), then call done on the executor of the connection (done
+  /// must keep the connection alive). The connection is closed if the
+  /// reply is not ready within the handler timeout.
+  template <typename Completion>
+  void wait_pending(Completion&& done)
+  {
+    set_timeout(timeout_phase::handler);
+    if (pending_->async)
+      start_async(std::forward<Completion>(done));
+    else
+      offload(std::forward<Completion>(done));
+  }
+
+  /// Start the asynchronous handler of the pending request.
+  template <typename Completion>
+  void start_async(Completion&& done)
+  {
+    auto async = std::move(pending_->async);
+    auto executor = socket_->get_executor();
+    // done can be move only, the reply can be sent by any thread
+    auto shared_done = std::make_shared<std::decay_t<Completion>>(std::forward<Completion>(done));
+    async->start(executor, [this, executor, shared_done](reply rep) {
+      asio::post(executor, [this, shared_done, rep = std::move(rep)]() mutable {
+        *pending_ = std::move(rep);
+        resume_pending();
+        std::move(*shared_done)();
+      });
+    });
+  }
+
+  /// Run the handler of the offloaded request on the worker pool, then call
+  /// done on the executor of the connection, when the reply is ready (done
+  /// must keep the connection alive). When too many requests are waiting for
+  /// the pool, the request is answered with "503 Service Unavailable" at once.
+  /// The content streamed by the handler is produced on the pool as well.
+  template <typename Completion>
+  void offload(Completion&& done)
+  {
+    worker_pool& workers = *request_handler_.workers();
+    auto executor = socket_->get_executor();
+    if (!workers.try_reserve())
+    {
+      *pending_ = reply::stock_reply(reply::service_unavailable);
+      resume_pending();
+      asio::post(executor, std::forward<Completion>(done));
+      return;
+    }
+
+    workers.post([this, &workers, executor, done = std::forward<Completion>(done)]() mutable {
+      std::exception_ptr error;
+      try
+      {
+        request_handler_.handle_request(request_, *pending_);
+        if (pending_->chunk_source)
+          pending_->chunk_source = offloaded_chunks(workers, std::move(pending_->chunk_source));
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+      asio::post(executor, [this, error, done = std::move(done)]() mutable {
+        if (error)
+        {
+          // as the handlers run inline, let the exception reach the io_context
+          connection_manager_.stop(this->shared_from_this());
+          std::rethrow_exception(error);
+        }
+        resume_pending();
+        done();
+      });
+    });
+  }
+
+  /// The chunk_source of an offloaded reply: each piece is produced by source
+  /// on the worker pool, while the connection waits for it as for a pending
+  /// piece (see wait_chunk).
+  static std::function<reply::chunk_status(std::string&, const std::function<void()>&)> offloaded_chunks(
+      worker_pool& workers, std::function<reply::chunk_status(std::string&, const std::function<void()>&)> source)
+  {
+    // the piece produced by the last job, handed over when the job resumes the connection
+    struct state
+    {
+      std::function<reply::chunk_status(std::string&, const std::function<void()>&)> source;
+      std::string chunk;
+      reply::chunk_status status = reply::chunk_status::pending;
+      std::exception_ptr error;
+    };
+    auto produced = std::make_shared<state>();
+    produced->source = std::move(source);
+
+    return [&workers, produced](std::string& chunk, const std::function<void()>& resume) {
+      if (produced->error)
+      {
+        // as the handlers run inline, let the exception reach the io_context
+        std::rethrow_exception(std::exchange(produced->error, nullptr));
+      }
+      if (produced->status != reply::chunk_status::pending)
+      {
+        chunk.swap(produced->chunk);
+        return std::exchange(produced->status, reply::chunk_status::pending);
+      }
+
+      workers.post_accepted([produced, resume]() {
+        produced->chunk.clear();
+        try
+        {
+          produced->status = produced->source(produced->chunk, resume);
+        }
+        catch (...)
+        {
+          produced->error = std::current_exception();
+        }
+        // a source pending in turn resumes the connection itself
+        if (produced->status != reply::chunk_status::pending || produced->error)
+          resume();
+      });
+      return reply::chunk_status::pending;
+    };
+  }
+
+  /// The reply of the pending request is ready: the parsing can go on.
+  void resume_pending()
+  {
+    reply& rep = *pending_;
+    pending_ = nullptr;
+    finish_request(rep);
+  }
+
+  /// Add the headers depending on the connection to the reply of the
+  /// request just handled, and get ready for the next request.
+  void finish_request(reply& rep)
+  {
+    if (rep.chunk_source)
+      add_transfer_encoding(rep);
+    if (request_.method_id() == http_method::head)
+    {
+      // the headers of the reply to GET (Content-Length or Transfer-Encoding
+      // included), without the content: the client doesn't read it
+      rep.content.clear();
+      rep.chunk_source = nullptr;
+    }
+    add_connection_header(rep);
+    reset_request();
+  }
+
+  /// Queue the reply to an invalid request: the connection is closed after it.
+  void queue_error(reply::status_type status)
+  {
+    keep_alive_ = false;
+    reading_body_ = false;
+    reply& rep = replies_.emplace_back(reply::stock_reply(status));
+    add_connection_header(rep);
+  }
+
+  /// Whether the connection goes on after the replies queued have been sent
+  /// (after "100 Continue", the body of the request is still to be read).
+  [[nodiscard]] bool keep_open() const { return keep_alive_ || reading_body_; }
+
+  /// Arm the timeout for the next read.
+  void set_read_timeout()
+  {
+    if (reading_body_)
+      set_timeout(timeout_phase::body);
+    // a new request starts when its first byte arrives
+    else
+      set_timeout(request_started_ || requests_served_ == 0 ? timeout_phase::header : timeout_phase::keep_alive);
+  }
+
+  /// Collect the buffers of the next piece of output into write_buffers_:
+  /// all the pending replies, in order, up to the first one streaming its
+  /// content, or the next chunk of the reply being streamed.
+  /// Return false when there is nothing left to write, or when the next
+  /// chunk is not ready (then chunk_pending_ is set: see wait_chunk).
+  bool prepare_write_buffers()
+  {
+    write_buffers_.clear();
+
+    if (streaming_)
+    {
+      reply& rep = replies_[next_reply_ - 1];
+      chunk_.clear();
+      auto status = reply::chunk_status::more;
+      while (status == reply::chunk_status::more && chunk_.empty())
+        status = rep.chunk_source(chunk_, stream_resume());
+      if (status == reply::chunk_status::pending)
+      {
+        chunk_pending_ = true;
+        return false;
+      }
+      if (status == reply::chunk_status::more)
+      {
+        add_chunk(chunk_);
+        return true;
+      }
+      // the content is over
+      streaming_ = false;
+      rep.chunk_source = nullptr;
+      stream_resume_ = nullptr;
+      if (!raw_stream_)
+        write_buffers_.push_back(asio::buffer(last_chunk));
+    }
+
+    while (next_reply_ < replies_.size())
+    {
+      reply& rep = replies_[next_reply_++];
+      const auto buffers = rep.to_buffers();
+      if (!rep.chunk_source)
+      {
+        write_buffers_.insert(write_buffers_.end(), buffers.begin(), buffers.end());
+        continue;
+      }
+      // the headers, then the content as the first chunk
+      write_buffers_.insert(write_buffers_.end(), buffers.begin(), buffers.end() - 1);
+      if (!rep.content.empty())
+        add_chunk(rep.content);
+      streaming_ = true;
+      break;
+    }
+
+    return !write_buffers_.empty();
+  }
+
+  /// Add a chunk of the reply being streamed to write_buffers_.
+  void add_chunk(const std::string& data)
+  {
+    if (raw_stream_)
+    {
+      write_buffers_.push_back(asio::buffer(data));
+      return;
+    }
+    // chunk-size CRLF chunk-data CRLF
+    auto* end = std::to_chars(chunk_size_.data(), chunk_size_.data() + chunk_size_.size() - 2, data.size(), 16).ptr;
+    *end++ = '\r';
+    *end++ = '\n';
+    write_buffers_.push_back(asio::buffer(chunk_size_.data(), static_cast<std::size_t>(end - chunk_size_.data())));
+    write_buffers_.push_back(asio::buffer(data));
+    write_buffers_.push_back(asio::buffer(crlf));
+  }
+
+  /// The function resuming the reply being streamed, passed to its producer.
+  /// A resume left by a previous stream is ignored.
+  const std::function<void()>& stream_resume()
+  {
+    if (!stream_resume_)
+    {
+      stream_resume_ = [weak = this->weak_from_this(), executor = socket_->get_executor(), id = ++stream_id_]() {
+        asio::post(executor, [weak, id]() {
+          if (auto self = weak.lock(); self && self->stream_id_ == id)
+            self->resume_chunk();
         });
+      };
+    }
+    return stream_resume_;
+  }
+
+  /// Wait until the producer of the reply being streamed, that has no chunk
+  /// ready, calls its resume function, then call done on the executor of
+  /// the connection. The connection is closed if the producer doesn't resume
+  /// within the handler timeout.
+  template <typename Completion>
+  void wait_chunk(Completion&& done)
+  {
+    set_timeout(timeout_phase::handler);
+    // done can be move only
+    chunk_waiter_ = [done = std::make_shared<std::decay_t<Completion>>(std::forward<Completion>(done))]() {
+      std::move(*done)();
+    };
   }
 
+  /// The producer of the reply being streamed has resumed.
+  void resume_chunk()
+  {
+    if (!chunk_pending_ || !chunk_waiter_)
+      return;
+    chunk_pending_ = false;
+    auto waiter = std::move(chunk_waiter_);
+    chunk_waiter_ = nullptr;
+    waiter();
+  }
+
+  /// All the pending replies have been sent.
+  void clear_replies()
+  {
+    replies_.clear();
+    next_reply_ = 0;
+    streaming_ = false;
+    chunk_pending_ = false;
+    chunk_waiter_ = nullptr;
+    stream_resume_ = nullptr;
+  }
+
+  /// Send the pending replies, in order, gathering them in as few writes as possible.
+  /// A reply streaming its content is sent a chunk at a time: the next chunk
+  /// is produced only when the previous one has been written.
   void do_write()
   {
     auto self{this->shared_from_this()};
-    asio::async_write(socket_, reply_.to_buffers(),
+
+    if (!prepare_write_buffers())
+    {
+      if (chunk_pending_)
+      {
+        // the connection manager keeps the connection alive meanwhile
+        wait_chunk([this]() { do_write(); });
+        return;
+      }
+
+      clear_replies();
+
+      if (keep_open())
+      {
+        // Go on with the pipelined requests, or wait for the next one.
+        process_buffer();
+        return;
+      }
+
+      // Initiate graceful connection closure.
+      asio::error_code ignored_ec;
+      socket_->lowest_layer().shutdown(asio::ip::tcp::socket::shutdown_both, ignored_ec);
+      connection_manager_.stop(self);
+      return;
+    }
+
+    set_timeout(timeout_phase::write);
+    asio::async_write(*socket_, write_buffers_,
+        make_custom_alloc_handler(write_memory_,
         [self](std::error_code ec, std::size_t)
         {
           if (!ec)
           {
-            // Initiate graceful connection closure.
-            asio::error_code ignored_ec;
-            self->socket_.lowest_layer().shutdown(asio::ip::tcp::socket::shutdown_both,
-              ignored_ec);
+            self->do_write();
+            return;
           }
 
+          self->clear_replies();
           if (ec != asio::error::operation_aborted)
           {
             self->connection_manager_.stop(self->shared_from_this());
           }
+        }));
+  }
+
+  /// Called by the timer wheel (with the wheel locked): the timeout is
+  /// handled by the executor of the connection.
+  void on_timer_expired()
+  {
+    asio::post(socket_->get_executor(),
+        [weak = this->weak_from_this(), generation = timer_.generation()]()
+        {
+          auto self = weak.lock();
+          // the connection has been closed, or the timer armed again
+          if (!self || generation != self->timer_.generation())
+            return;
+          self->connection_manager_.stop(self);
         });
   }
 
-  SocketType socket_;
+  /// Tell the client whether the connection will be kept open after this reply.
+  void add_connection_header(reply& rep) const
+  {
+    if (!keep_alive_)
+      rep.headers.push_back({"Connection", "close"});
+    else if (request_.http_version_major == 1 && request_.http_version_minor == 0)
+      rep.headers.push_back({"Connection", "keep-alive"});
+  }
+
+  /// Announce the framing of a reply that streams its content.
+  /// HTTP/1.0 clients don't know chunks: the content is sent as is, and
+  /// its end is marked by closing the connection.
+  void add_transfer_encoding(reply& rep)
+  {
+    if (request_.http_version_major == 1 && request_.http_version_minor == 0)
+    {
+      keep_alive_ = false;
+      raw_stream_ = true;
+      return;
+    }
+    rep.headers.push_back({"Transfer-Encoding", "chunked"});
+  }
+
+  /// Get ready to parse a new request on the same connection.
+  void reset_request()
+  {
+    request_parser_.reset();
+    request_.clear();
+    body_parser_.reset();
+    body_reader_.reset();
+    reading_body_ = false;
+    head_end_ = 0;
+  }
+
+  /// Get ready to serve a new client, when the connection is recycled.
+  /// The derived class is in charge of replacing socket_.
+  void reset_state()
+  {
+    timer_.cancel();
+    phase_ = timeout_phase::none;
+    request_started_ = false;
+    reset_request();
+    buffer_begin_ = 0;
+    buffer_end_ = 0;
+    request_start_ = 0;
+    clear_replies();
+    pending_ = nullptr;
+    raw_stream_ = false;
+    requests_served_ = 0;
+    keep_alive_ = false;
+  }
+
+  /// The stream to the client, replaced when the connection is recycled.
+  std::optional<SocketType> socket_;
 
   /// The manager for this connection.
   connection_manager& connection_manager_;
@@ -103,17 +731,91 @@ protected:
   /// The handler used to process the incoming request.
   request_handler& request_handler_;
 
+  /// The settings of the server owning this connection.
+  const server_settings& settings_;
+
+  /// The timer of the current timeout (declared after socket_, so that
+  /// it's cancelled before socket_ is destroyed).
+  timer_wheel::timer timer_;
+
+  /// What the timer of the connection is waiting for.
+  timeout_phase phase_ = timeout_phase::none;
+
+  /// Whether part of the next request has been received.
+  bool request_started_ = false;
+
   /// Buffer for incoming data.
   std::array<char, 8192> buffer_;
 
-  /// The incoming request.
+  /// The data of buffer_ still to be parsed.
+  std::size_t buffer_begin_ = 0;
+  std::size_t buffer_end_ = 0;
+
+  /// Where the request being received starts in buffer_ (and where its head ends,
+  /// while the body is arriving).
+  std::size_t request_start_ = 0;
+  std::size_t head_end_ = 0;
+
+  /// The incoming request (it refers to its data in buffer_).
   http_request request_;
 
   /// The parser for the incoming request.
   request_parser request_parser_;
 
-  /// The reply to be sent back to the client.
-  reply reply_;
+  /// The parser for the body of the incoming request.
+  body_parser body_parser_;
+
+  /// The consumer of the body of the incoming request (if it streams the body).
+  std::unique_ptr<body_reader> body_reader_;
+
+  /// Whether the headers of the incoming request have been parsed, and its body is arriving.
+  bool reading_body_ = false;
+
+  /// The replies to be sent back to the client, in the order of the requests.
+  std::vector<reply> replies_;
+
+  /// The reply (in replies_) not ready yet, if any: its handler runs on the
+  /// worker pool, or it's asynchronous.
+  reply* pending_ = nullptr;
+
+  /// The buffers of all the replies sent with a single write.
+  std::vector<asio::const_buffer> write_buffers_;
+
+  /// The first reply of replies_ not written yet.
+  std::size_t next_reply_ = 0;
+
+  /// Whether the reply before next_reply_ is streaming its content.
+  bool streaming_ = false;
+
+  /// Whether the streamed content is sent without chunks (HTTP/1.0).
+  bool raw_stream_ = false;
+
+  /// Whether the producer of the reply being streamed has no chunk ready,
+  /// and what to do when it resumes (see wait_chunk).
+  bool chunk_pending_ = false;
+  std::function<void()> chunk_waiter_;
+
+  /// The resume function of the reply being streamed, and the number of
+  /// the streams started, that tells it from the ones of the previous streams.
+  std::function<void()> stream_resume_;
+  std::size_t stream_id_ = 0;
+
+  /// The chunk of content being written, and its size line.
+  std::string chunk_;
+  std::array<char, 20> chunk_size_{};
+
+  static constexpr std::string_view crlf{"\r\n"};
+  static constexpr std::string_view last_chunk{"0\r\n\r\n"};
+
+  /// Number of requests received on this connection.
+  std::size_t requests_served_ = 0;
+
+  /// Whether the connection must be kept open after the current reply.
+  bool keep_alive_ = false;
+
+  /// Recycled memory for the completion handlers of the reads and the writes.
+  handler_memory read_memory_;
+  handler_memory write_memory_;
 
 };
 
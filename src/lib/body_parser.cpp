@@ -0,0 +1,211 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "body_parser.hpp"
+#include "http_request.hpp"
+#include <cctype>
+#include <limits>
+#include <string_view>
+
+namespace f16::http::server {
+
+namespace {
+
+bool iequals(std::string_view a, const char* b)
+{
+  std::size_t i = 0;
+  for (; i < a.size() && b[i] != '\0'; ++i)
+    if (std::tolower(static_cast<unsigned char>(a[i])) != b[i])
+      return false;
+  return i == a.size() && b[i] == '\0';
+}
+
+std::string_view trim(std::string_view s)
+{
+  const auto first = s.find_first_not_of(" \t");
+  if (first == std::string_view::npos)
+    return {};
+  const auto last = s.find_last_not_of(" \t");
+  return s.substr(first, last - first + 1);
+}
+
+/// Parse a non negative decimal number, checking for overflow.
+bool parse_length(std::string_view s, std::uint64_t& value)
+{
+  const std::string_view digits = trim(s);
+  if (digits.empty())
+    return false;
+  value = 0;
+  for (char c : digits)
+  {
+    if (c < '0' || c > '9')
+      return false;
+    const auto digit = static_cast<std::uint64_t>(c - '0');
+    if (value > (std::numeric_limits<std::uint64_t>::max() - digit) / 10)
+      return false;
+    value = value * 10 + digit;
+  }
+  return true;
+}
+
+int hex_value(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+} // namespace
+
+void body_parser::reset()
+{
+  state_ = data;
+  chunked_ = false;
+  max_size_ = 0;
+  remaining_ = 0;
+  size_ = 0;
+}
+
+body_parser::result_type body_parser::start(const http_request& req, std::uint64_t max_size)
+{
+  reset();
+  max_size_ = max_size;
+
+  // most requests have no body: the index tells it without a scan
+  if (!req.has_header(known_header::content_length) && !req.has_header(known_header::transfer_encoding))
+    return good;
+
+  bool has_length = false;
+  std::uint64_t length = 0;
+  std::string_view encoding; // the last one (a single one is accepted)
+  std::size_t encodings = 0;
+  for (const auto& h : req.headers)
+  {
+    if (iequals(h.name, "content-length"))
+    {
+      std::uint64_t value = 0;
+      // repeated headers are accepted only when they agree
+      if (!parse_length(h.value, value) || (has_length && value != length))
+        return bad;
+      has_length = true;
+      length = value;
+    }
+    else if (iequals(h.name, "transfer-encoding"))
+    {
+      const std::string_view value = trim(h.value);
+      if (!value.empty())
+      {
+        encoding = value;
+        ++encodings;
+      }
+    }
+  }
+
+  if (encodings != 0)
+  {
+    // chunked is the only coding supported, and a length together
+    // with a transfer coding could be used to smuggle requests
+    if (encodings != 1 || !iequals(encoding, "chunked") || has_length)
+      return bad;
+    chunked_ = true;
+    state_ = chunk_size_start;
+    return indeterminate;
+  }
+
+  if (!has_length || length == 0)
+    return good;
+  if (max_size_ != 0 && length > max_size_)
+    return too_large;
+  remaining_ = length;
+  return indeterminate;
+}
+
+body_parser::result_type body_parser::consume(char input) // NOLINT
+{
+  switch (state_)
+  {
+  case chunk_size_start:
+  {
+    const int digit = hex_value(input);
+    if (digit < 0)
+      return bad;
+    remaining_ = static_cast<std::uint64_t>(digit);
+    state_ = chunk_size;
+    return indeterminate;
+  }
+  case chunk_size:
+  {
+    if (input == '\r')
+    {
+      state_ = chunk_size_lf;
+      return indeterminate;
+    }
+    if (input == ';' || input == ' ' || input == '\t')
+    {
+      state_ = chunk_extension;
+      return indeterminate;
+    }
+    const int digit = hex_value(input);
+    if (digit < 0 || remaining_ > (std::numeric_limits<std::uint64_t>::max() >> 4))
+      return bad;
+    remaining_ = (remaining_ << 4) | static_cast<std::uint64_t>(digit);
+    return indeterminate;
+  }
+  case chunk_extension:
+    // the extensions are ignored
+    if (input == '\r')
+      state_ = chunk_size_lf;
+    else if (input == '\n')
+      return bad;
+    return indeterminate;
+  case chunk_size_lf:
+    if (input != '\n')
+      return bad;
+    if (remaining_ == 0)
+    {
+      state_ = trailer_line_start;
+      return indeterminate;
+    }
+    // the size of the chunk is known before its data arrives
+    if (max_size_ != 0 && remaining_ > max_size_ - size_)
+      return too_large;
+    state_ = data;
+    return indeterminate;
+  case chunk_data_cr:
+    if (input != '\r')
+      return bad;
+    state_ = chunk_data_lf;
+    return indeterminate;
+  case chunk_data_lf:
+    if (input != '\n')
+      return bad;
+    state_ = chunk_size_start;
+    return indeterminate;
+  case trailer_line_start:
+    // the trailer fields are ignored
+    state_ = input == '\r' ? final_lf : trailer_line;
+    return indeterminate;
+  case trailer_line:
+    if (input == '\r')
+      state_ = trailer_lf;
+    return indeterminate;
+  case trailer_lf:
+    if (input != '\n')
+      return bad;
+    state_ = trailer_line_start;
+    return indeterminate;
+  case final_lf:
+    return input == '\n' ? good : bad;
+  case data:
+  default:
+    return bad;
+  }
+}
+
+} // namespace f16::http::server
@@ -0,0 +1,106 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_BODY_PARSER_HPP
+#define F16_HTTP_BODY_PARSER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+namespace f16::http::server {
+
+struct http_request;
+
+/// Parser for the body of the incoming requests.
+/// The length of the body comes from the "Content-Length" header, or from
+/// the chunks of "Transfer-Encoding: chunked". The body is not stored:
+/// the decoded data is passed to a sink, a piece at a time, as it arrives.
+class body_parser
+{
+public:
+  /// Result of start and parse.
+  enum result_type { good, bad, too_large, indeterminate };
+
+  /// Get ready for the body of a request, given its headers.
+  /// The enum return value is good when the request has no body, bad if
+  /// the headers describing the body are invalid, too_large if the body
+  /// is known to be longer than max_size (0 = unlimited), indeterminate
+  /// when the body must be parsed.
+  result_type start(const http_request& req, std::uint64_t max_size);
+
+  /// Reset to initial parser state.
+  void reset();
+
+  /// Parse some data. The enum return value is good when the whole body
+  /// has been parsed, bad if the data is invalid, too_large if the body
+  /// exceeds the maximum size, indeterminate when more data is required.
+  /// Each piece of the body is passed to sink(const char* data, std::size_t size).
+  /// The pointer return value indicates how much of the input has been consumed.
+  template <typename Sink>
+  std::tuple<result_type, const char*> parse(const char* begin, const char* end, Sink&& sink)
+  {
+    while (begin != end)
+    {
+      if (state_ == data)
+      {
+        // the data is passed as is, without looking at each char
+        const auto size = static_cast<std::size_t>(
+            std::min<std::uint64_t>(remaining_, static_cast<std::uint64_t>(end - begin)));
+        sink(begin, size);
+        begin += size;
+        remaining_ -= size;
+        size_ += size;
+        if (remaining_ == 0)
+        {
+          if (!chunked_)
+            return std::make_tuple(good, begin);
+          state_ = chunk_data_cr;
+        }
+        continue;
+      }
+      result_type result = consume(*begin++);
+      if (result != indeterminate)
+        return std::make_tuple(result, begin);
+    }
+    return std::make_tuple(indeterminate, begin);
+  }
+
+  /// Number of bytes of body received so far.
+  [[nodiscard]] std::uint64_t size() const { return size_; }
+
+  /// Whether the body is chunked.
+  [[nodiscard]] bool chunked() const { return chunked_; }
+
+private:
+  /// Handle the next character of the chunked framing.
+  result_type consume(char input);
+
+  /// The current state of the parser.
+  enum state
+  {
+    data,
+    chunk_size_start,
+    chunk_size,
+    chunk_extension,
+    chunk_size_lf,
+    chunk_data_cr,
+    chunk_data_lf,
+    trailer_line_start,
+    trailer_line,
+    trailer_lf,
+    final_lf
+  } state_ = data;
+
+  bool chunked_ = false;
+  std::uint64_t max_size_ = 0;
+  std::uint64_t remaining_ = 0; // of the body or of the current chunk
+  std::uint64_t size_ = 0;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_BODY_PARSER_HPP
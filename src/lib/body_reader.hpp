@@ -0,0 +1,33 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_BODY_READER_HPP
+#define F16_HTTP_BODY_READER_HPP
+
+#include <cstddef>
+
+namespace f16::http::server {
+
+struct reply;
+
+/// Consumes the body of a request while it's received, instead of
+/// collecting the whole body in memory.
+/// It's created by the request handler as soon as the headers arrive.
+class body_reader
+{
+public:
+  virtual ~body_reader() = default;
+
+  /// A piece of the body (already decoded, when chunked).
+  /// The data is valid only during the call.
+  virtual void on_data(const char* data, std::size_t size) = 0;
+
+  /// The whole body has been received: produce the reply.
+  virtual void on_complete(reply& rep) = 0;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_BODY_READER_HPP
@@ -7,6 +7,8 @@
 
 namespace f16::http::server {
 
+std::atomic<std::size_t> connection_manager::total_size_{ 0 }; // NOLINT
+
 connection_manager::connection_manager() = default;
 
 connection_manager::~connection_manager()
@@ -16,22 +18,46 @@ connection_manager::~connection_manager()
 
 void connection_manager::start(const connection_ptr& c)
 {
-  connections_.insert(c);
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (connections_.insert(c).second)
+    {
+      ++size_;
+      ++total_size_;
+    }
+  }
   c->start();
 }
 
 void connection_manager::stop(const connection_ptr& c)
 {
-  connections_.erase(c);
+  bool removed = false;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    removed = connections_.erase(c) != 0;
+    if (removed)
+    {
+      --size_;
+      --total_size_;
+    }
+  }
   c->stop();
+  if (removed && on_stop_)
+    on_stop_();
 }
 
 
 void connection_manager::stop_all()
 {
-  for (const auto& c: connections_)
+  std::unordered_set<connection_ptr> connections;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    connections.swap(connections_);
+    size_ -= connections.size();
+    total_size_ -= connections.size();
+  }
+  for (const auto& c: connections)
     c->stop();
-  connections_.clear();
 }
 
 } // namespace f16::http::server
@@ -6,13 +6,17 @@
 #ifndef F16_HTTP_CONNECTION_MANAGER_HPP
 #define F16_HTTP_CONNECTION_MANAGER_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
 #include <unordered_set>
 #include "connection.hpp"
 
 namespace f16::http::server {
 
 /// Manages open connections so that they may be cleanly stopped when the server
-/// needs to shut down.
+/// needs to shut down. The connections can be started and stopped from any thread.
 class connection_manager
 {
 public:
@@ -30,12 +34,33 @@ public:
   /// Stop the specified connection.
   void stop(const connection_ptr& c);
 
+  /// Set a function to be called each time a connection is removed
+  /// (from the thread stopping the connection). Must be set before
+  /// starting any connection.
+  void on_stop(std::function<void()> handler) { on_stop_ = std::move(handler); }
+
+  /// Number of connections of this manager.
+  [[nodiscard]] std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  /// Number of connections of all the managers of the process.
+  [[nodiscard]] static std::size_t total_size() { return total_size_.load(std::memory_order_relaxed); }
+
 private:
   /// Stop all connections.
   void stop_all();
 
   /// The managed connections.
   std::unordered_set<connection_ptr> connections_;
+
+  /// Protects connections_.
+  std::mutex mutex_;
+
+  /// Number of connections of this manager and of all the managers.
+  std::atomic<std::size_t> size_{ 0 };
+  static std::atomic<std::size_t> total_size_;
+
+  /// Called when a connection is removed.
+  std::function<void()> on_stop_;
 };
 
 } // namespace f16::http::server
@@ -0,0 +1,113 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_CONNECTION_POOL_HPP
+#define F16_HTTP_CONNECTION_POOL_HPP
+
+#include "f16asio.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace f16::http::server {
+
+/// Counters of a connection_pool.
+struct connection_pool_stats
+{
+  /// Connections served by a recycled object.
+  std::size_t hits = 0;
+
+  /// Connections that required a new object.
+  std::size_t misses = 0;
+};
+
+/// A bounded pool of connection objects.
+/// When the last reference to a connection goes away, the object returns
+/// to the pool (instead of being deleted), so that its buffers can be reused
+/// by a later connection. Connection must provide reset(asio::ip::tcp::socket).
+template <typename Connection>
+class connection_pool
+{
+public:
+  connection_pool(const connection_pool&) = delete;
+  connection_pool& operator=(const connection_pool&) = delete;
+
+  /// Construct a pool keeping at most capacity idle objects (0 disables the pool).
+  explicit connection_pool(std::size_t capacity) : state_(std::make_shared<state>(capacity)) {}
+
+  ~connection_pool()
+  {
+    // the connections still alive will be deleted when released
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->closed = true;
+    state_->idle.clear();
+  }
+
+  /// Get a connection for the socket, recycling an idle object when available.
+  /// The other arguments are passed to the Connection constructor, when a new
+  /// object is needed.
+  template <typename... Args>
+  std::shared_ptr<Connection> acquire(asio::ip::tcp::socket socket, Args&&... args)
+  {
+    std::unique_ptr<Connection> c;
+    {
+      const std::lock_guard<std::mutex> lock(state_->mutex);
+      if (!state_->idle.empty())
+      {
+        c = std::move(state_->idle.back());
+        state_->idle.pop_back();
+      }
+    }
+
+    if (c)
+    {
+      ++state_->hits;
+      c->reset(std::move(socket));
+    }
+    else
+    {
+      ++state_->misses;
+      c = std::make_unique<Connection>(std::move(socket), std::forward<Args>(args)...);
+    }
+
+    return std::shared_ptr<Connection>(c.release(), [s = state_](Connection* p) { release(*s, p); });
+  }
+
+  /// Get the pool counters.
+  [[nodiscard]] connection_pool_stats stats() const
+  {
+    return { state_->hits.load(), state_->misses.load() };
+  }
+
+private:
+  /// The pool data, shared with the deleters of the connections:
+  /// a connection can outlive its pool.
+  struct state
+  {
+    explicit state(std::size_t c) : capacity(c) {}
+    const std::size_t capacity;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Connection>> idle;
+    bool closed = false;
+    std::atomic<std::size_t> hits{0};
+    std::atomic<std::size_t> misses{0};
+  };
+
+  static void release(state& s, Connection* p)
+  {
+    std::unique_ptr<Connection> c(p);
+    const std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.closed && s.idle.size() < s.capacity)
+      s.idle.push_back(std::move(c));
+  }
+
+  std::shared_ptr<state> state_;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_CONNECTION_POOL_HPP
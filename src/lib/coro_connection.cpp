@@ -0,0 +1,113 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "coro_connection.hpp"
+
+#if defined(ASIO_HAS_CO_AWAIT)
+
+#include <exception>
+#include <utility>
+#include "connection_manager.hpp"
+#include "request_handler.hpp"
+
+namespace f16::http::server {
+
+coro_connection::coro_connection(asio::ip::tcp::socket socket,
+    connection_manager& manager, request_handler& handler,
+    const server_settings& settings, timer_wheel& timers)
+  : base_connection(std::move(socket), manager, handler, settings, timers)
+{
+}
+
+void coro_connection::reset(asio::ip::tcp::socket socket)
+{
+  socket_.emplace(std::move(socket));
+  reset_state();
+}
+
+void coro_connection::start()
+{
+  set_timeout(timeout_phase::header);
+  asio::co_spawn(socket_->get_executor(), run(shared_from_this()),
+      [](std::exception_ptr e)
+      {
+        // as the callback connections, let the exceptions of the
+        // request handlers reach the io_context
+        if (e)
+          std::rethrow_exception(e);
+      });
+}
+
+asio::awaitable<void> coro_connection::run(connection_ptr self)
+{
+  asio::error_code ec;
+  try
+  {
+    for (;;)
+    {
+      parse_requests();
+
+      if (pending_ != nullptr)
+      {
+        // go on when the reply of the request is ready
+        co_await asio::async_initiate<const asio::use_awaitable_t<>&, void()>(
+            [this](auto done) { wait_pending(std::move(done)); }, asio::use_awaitable);
+        continue;
+      }
+
+      if (replies_.empty())
+      {
+        set_read_timeout();
+        const std::size_t bytes_transferred = co_await socket_->async_read_some(
+            read_buffer(), asio::redirect_error(asio::use_awaitable, ec));
+        if (ec)
+          break;
+        buffer_end_ += bytes_transferred;
+        continue;
+      }
+
+      // Send all the pending replies, in order, gathering them in as few writes as possible.
+      for (;;)
+      {
+        if (!prepare_write_buffers())
+        {
+          if (!chunk_pending_)
+            break;
+          // the producer of the reply being streamed has no chunk ready
+          co_await asio::async_initiate<const asio::use_awaitable_t<>&, void()>(
+              [this](auto done) { wait_chunk(std::move(done)); }, asio::use_awaitable);
+          continue;
+        }
+        set_timeout(timeout_phase::write);
+        co_await asio::async_write(*socket_, write_buffers_, asio::redirect_error(asio::use_awaitable, ec));
+        if (ec)
+          break;
+      }
+      clear_replies();
+      if (ec)
+        break;
+
+      if (!keep_open())
+      {
+        // Initiate graceful connection closure.
+        asio::error_code ignored_ec;
+        socket_->shutdown(asio::ip::tcp::socket::shutdown_both, ignored_ec);
+        break;
+      }
+    }
+  }
+  catch (...)
+  {
+    connection_manager_.stop(self);
+    throw;
+  }
+
+  if (ec != asio::error::operation_aborted)
+    connection_manager_.stop(self);
+}
+
+} // namespace f16::http::server
+
+#endif // defined(ASIO_HAS_CO_AWAIT)
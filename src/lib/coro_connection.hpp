@@ -0,0 +1,51 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_CORO_CONNECTION_HPP
+#define F16_HTTP_CORO_CONNECTION_HPP
+
+#include "f16asio.hpp"
+#include "base_connection.hpp"
+
+// requires C++20 coroutines
+#if defined(ASIO_HAS_CO_AWAIT)
+
+namespace f16::http::server {
+
+class connection_manager;
+
+/// A plain connection driven by a coroutine instead of a chain of callbacks
+/// (see server_settings::coroutine_connections).
+/// The state of the whole connection lives in a single coroutine frame
+/// (allocated by the recycling allocator of asio), that keeps the connection
+/// alive until it ends: no shared_from_this copy is needed for each operation.
+class coro_connection
+  : public base_connection<asio::ip::tcp::socket>
+{
+public:
+  coro_connection(const coro_connection&) = delete;
+  coro_connection& operator=(const coro_connection&) = delete;
+
+  /// Construct a coro_connection with the given socket.
+  explicit coro_connection(asio::ip::tcp::socket socket,
+      connection_manager& manager, request_handler& handler,
+      const server_settings& settings, timer_wheel& timers);
+
+  void start() override;
+
+  /// Bind the connection to a new client, reusing its buffers.
+  void reset(asio::ip::tcp::socket socket);
+
+private:
+
+  /// Read the requests and write the replies until the connection is closed.
+  asio::awaitable<void> run(connection_ptr self);
+};
+
+} // namespace f16::http::server
+
+#endif // defined(ASIO_HAS_CO_AWAIT)
+
+#endif // F16_HTTP_CORO_CONNECTION_HPP
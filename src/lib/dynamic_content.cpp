@@ -3,60 +3,201 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
 
-#include <sstream>
 #include <string>
 #include "dynamic_content.hpp"
+#include "body_reader.hpp"
 #include "mime_types.hpp"
 #include "reply.hpp"
-#include "string.hpp"
 #include "request.hpp"
 
 namespace f16::http::server {
 
-dynamic_content::dynamic_content(std::string _action, std::function<void(const request&, response_stream&)> _handler) : 
-  action{std::move(_action)},
-  handler{std::move(_handler)}
-{
-}
+namespace {
 
-bool dynamic_content::serve_if_match(const std::string& location, const std::string& request_path, const http_request& http_req, reply& rep) const
+void fill_reply(response_stream& ss, reply& rep)
 {
-  auto res_query = split_string(request_path);
-  const auto& resources = res_query.first;
-  const auto& query = res_query.second;
-
-  request req{http_req};
-  if (!match_pattern(location, resources, req.resources))
-    return false;
-
-  handle_query_parameters(query, req);
-
-  response_stream ss;
-  handler(req, ss);
-  rep.content = ss.str();
+  rep.content = ss.take();
   rep.status = ss.status;
+  if (ss.producer)
+  {
+    // the connection adds the Transfer-Encoding header
+    rep.chunk_source = std::move(ss.producer);
+    rep.headers = {{"Content-Type", ss.content_type}};
+    return;
+  }
   rep.headers = {
     {"Content-Length", std::to_string(rep.content.size())},
     // {"Content-Type", mime_types::extension_to_type(".txt")} // TODO: use a more appropriate content type
     {"Content-Type", ss.content_type}
   };
+}
 
+/// Forward the body of a request to a body_stream.
+class stream_reader : public body_reader
+{
+public:
+  explicit stream_reader(body_stream s) : stream(std::move(s)) {}
+
+  void on_data(const char* data, std::size_t size) override
+  {
+    if (stream.on_data)
+      stream.on_data(std::string_view(data, size));
+  }
+
+  void on_complete(reply& rep) override
+  {
+    response_stream ss;
+    if (stream.on_complete)
+      stream.on_complete(ss);
+    fill_reply(ss, rep);
+  }
+
+private:
+  body_stream stream;
+};
+
+} // namespace
+
+async_reply::async_reply(const async_handler& handler, const http_request& req, const path_params& params, std::string_view query) :
+  handler_{handler},
+  req_{req}
+{
+  std::size_t size = query.size();
+  for (std::size_t i = 0; i < params.size(); ++i)
+    size += params[i].second.size();
+  values_.reserve(size);
+  // the names are views on the location, that outlives the request
+  for (std::size_t i = 0; i < params.size(); ++i)
+  {
+    const auto [name, value] = params[i];
+    const std::size_t pos = values_.size();
+    values_.append(value);
+    req_.resources.add(name, std::string_view(values_).substr(pos, value.size()));
+  }
+  const std::size_t pos = values_.size();
+  values_.append(query);
+  req_.querystring = query_string{std::string_view(values_).substr(pos)};
+}
+
+async_reply::~async_reply()
+{
+  if (!ready_ || sent_)
+    return;
+  // the handler forgot the response (or threw)
+  try
+  {
+    ready_(reply::stock_reply(reply::internal_server_error));
+  }
+  catch (...)
+  {
+    // nothing to do in the destructor
+  }
+}
+
+void async_reply::start(asio::any_io_executor executor, std::function<void(reply)> ready)
+{
+  executor_ = std::move(executor);
+  ready_ = std::move(ready);
+  handler_(req_, f16::async_response(shared_from_this()));
+}
+
+void async_reply::send()
+{
+  if (sent_.exchange(true))
+    return;
+  reply rep;
+  fill_reply(stream_, rep);
+  ready_(std::move(rep));
+}
+
+dynamic_content::dynamic_content(std::string _action, response_writer<const request&> _handler) : 
+  action{std::move(_action)},
+  handler{std::move(_handler)}
+{
+}
+
+dynamic_content dynamic_content::streaming(std::string action, std::function<body_stream(const request&)> stream_handler)
+{
+  dynamic_content content{std::move(action), {}};
+  content.stream_handler = std::move(stream_handler);
+  return content;
+}
+
+dynamic_content dynamic_content::asynchronous(std::string action, async_handler handler)
+{
+  dynamic_content content{std::move(action), {}};
+  content.async_fn = std::move(handler);
+  return content;
+}
+
+bool dynamic_content::split(const route_pattern& location, const std::string& request_path, path_params& params, std::string_view& query)
+{
+  const auto query_start = request_path.find('?');
+  if (!location.match(std::string_view(request_path).substr(0, query_start), params))
+    return false;
+  if (query_start != std::string::npos)
+    query = std::string_view(request_path).substr(query_start + 1);
+  return true;
+}
+
+bool dynamic_content::serve_if_match(const route_pattern& location, const std::string& request_path, const http_request& http_req, reply& rep) const
+{
+  path_params params;
+  std::string_view query;
+  if (!split(location, request_path, params, query))
+    return false;
+  serve(params, query, http_req, rep);
   return true;
 }
 
-void dynamic_content::handle_query_parameters(const std::string& query, request& req) {
-  std::vector<std::string> params;
-  std::stringstream s{query};
-  std::string temp;
+bool dynamic_content::open_body_if_match(const route_pattern& location, const std::string& request_path, const http_request& http_req,
+    std::unique_ptr<body_reader>& reader) const
+{
+  path_params params;
+  std::string_view query;
+  if (!split(location, request_path, params, query))
+    return false;
+  open_body(params, query, http_req, reader);
+  return true;
+}
 
-  while (std::getline(s, temp, '&')) {
-    params.push_back(temp);
+void dynamic_content::serve(const path_params& params, std::string_view query, const http_request& http_req, reply& rep) const
+{
+  if (async_fn)
+  {
+    // the connection starts the handler
+    rep.async = std::make_shared<async_reply>(async_fn, http_req, params, query);
+    return;
   }
 
-  for (const auto& param : params) {
-    auto key_value = split_string(param, '=');
-    req.add_queryvalue(key_value.first, key_value.second);
+  request req{http_req};
+  req.resources = params;
+  req.querystring = query_string{query};
+
+  if (stream_handler)
+  {
+    // no body: the stream ends immediately
+    stream_reader reader{stream_handler(req)};
+    reader.on_complete(rep);
+    return;
   }
+
+  response_stream ss;
+  handler(req, ss);
+  fill_reply(ss, rep);
+}
+
+void dynamic_content::open_body(const path_params& params, std::string_view query, const http_request& http_req,
+    std::unique_ptr<body_reader>& reader) const
+{
+  // otherwise, the body is collected in the request
+  if (!stream_handler)
+    return;
+
+  request req{http_req};
+  req.resources = params;
+  req.querystring = query_string{query};
+  reader = std::make_unique<stream_reader>(stream_handler(req));
 }
 
 } // namespace f16::http::server
@@ -7,85 +7,138 @@
 #define F16_HTTP_DYNAMIC_CONTENT_HPP
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <functional>
-#include <sstream>
+#include "async_response.hpp"
 #include "reply.hpp"
+#include "response_stream.hpp"
+#include "route_pattern.hpp"
 
-namespace f16 {
-struct response_stream : public std::ostringstream {
-  std::string content_type = "text/plain"; // default
-  http::server::reply::status_type status = http::server::reply::ok; // default status
+namespace f16::http::server {
+
+// forward declarations
+struct http_request;
+struct request;
+struct reply;
+class body_reader;
+
+/// The handlers of a request whose body is consumed while it's received,
+/// instead of being collected in request::body() (see post_stream and put_stream).
+struct body_stream
+{
+  /// Called for each piece of the body, as it arrives.
+  std::function<void(std::string_view data)> on_data;
+
+  /// Called when the whole body has been received, to write the response.
+  response_writer<> on_complete;
 };
 
-// f16 manipolators for response_stream
-inline response_stream& json(response_stream& os) {
-  os.content_type = "application/json";
-  return os;
-}
+class dynamic_content
+{
+public:
+  dynamic_content(std::string action, response_writer<const request&> _handler);
 
-inline response_stream& xml(response_stream& os) {
-  os.content_type = "application/xml";
-  return os;
-}
+  /// A resource that streams the request body: stream_handler is called as soon as
+  /// the headers are received (the request is valid only during the call).
+  static dynamic_content streaming(std::string action, std::function<body_stream(const request& req)> stream_handler);
 
-inline response_stream& plain(response_stream& os) {
-  os.content_type = "text/plain";
-  return os;
-}
+  /// A resource whose handler completes the response after returning (see get_async).
+  static dynamic_content asynchronous(std::string action, async_handler handler);
 
-inline response_stream& ok(response_stream& os) {
-  os.status = http::server::reply::ok;
-  return os;
-}
+  bool serve_if_match(const route_pattern& location, const std::string& request_path, const http_request& req, reply& rep) const;
 
-inline response_stream& bad_request(response_stream& os) {
-  os.status = http::server::reply::bad_request;
-  return os;
-}
+  bool serve_if_match(const std::string& location, const std::string& request_path, const http_request& req, reply& rep) const
+  {
+    return serve_if_match(route_pattern{location}, request_path, req, rep);
+  }
 
-inline response_stream& operator<<(response_stream& os, response_stream& (*f)(response_stream&)) {
-  return f(os);
-}
+  /// If the request matches, set reader to the consumer of its body
+  /// (left empty when the body must be collected in the request).
+  bool open_body_if_match(const route_pattern& location, const std::string& request_path, const http_request& req,
+      std::unique_ptr<body_reader>& reader) const;
 
-} // namespace f16
+  /// Serve a request whose path has already been matched with the location,
+  /// given the parameters of the path and the query string (not decoded yet).
+  void serve(const path_params& params, std::string_view query, const http_request& req, reply& rep) const;
 
-namespace f16::http::server {
+  /// Like open_body_if_match, for a request whose path has already been matched.
+  void open_body(const path_params& params, std::string_view query, const http_request& req,
+      std::unique_ptr<body_reader>& reader) const;
 
-// forward declarations
-struct http_request;
-struct request;
-struct reply;
+  [[nodiscard]] std::string_view method() const { return action; }
 
-class dynamic_content
-{
-public:
-  dynamic_content(std::string action, std::function<void(const request& req, response_stream&)> _handler);
-  bool serve_if_match(const std::string& location, const std::string& request_path, const http_request& req, reply& rep) const;
-  [[nodiscard]] std::string method() const { return action; }
+  /// Run the handler on the worker pool of the server (see server_settings::worker_threads)
+  /// instead of the I/O thread, for the handlers that block (e.g., database queries, file scans).
+  /// The producer of a streamed response (see response_stream::stream) runs on the pool too,
+  /// each piece in a new job. The resources streaming the request body, and the asynchronous
+  /// ones, always run on the I/O thread.
+  dynamic_content& offload()
+  {
+    offloaded = true;
+    return *this;
+  }
+
+  [[nodiscard]] bool is_offloaded() const { return offloaded && !stream_handler && !async_fn; }
 
 private:
-  static void handle_query_parameters(const std::string& query, request& req);
+  /// Extract the path parameters and the query of the request, if the path matches.
+  static bool split(const route_pattern& location, const std::string& request_path, path_params& params, std::string_view& query);
 
   std::string action;
-  std::function<void(const request&, response_stream&)> handler;
+  response_writer<const request&> handler;
+  std::function<body_stream(const request&)> stream_handler;
+  async_handler async_fn;
+  bool offloaded = false;
 };
 
-inline dynamic_content get(std::function<void(const request& req, response_stream&)> _handler)
+inline dynamic_content get(response_writer<const request&> _handler)
 {
   return dynamic_content("GET", _handler);
 }
 
-inline dynamic_content post(std::function<void(const request& req, response_stream&)> _handler)
+inline dynamic_content post(response_writer<const request&> _handler)
 {
   return dynamic_content("POST", _handler);
 }
 
-inline dynamic_content put(std::function<void(const request& req, response_stream&)> _handler)
+inline dynamic_content put(response_writer<const request&> _handler)
 {
   return dynamic_content("PUT", _handler);
 }
 
+/// The handler gets an async_response, to send when the response is complete,
+/// from any thread (e.g., from the completion of a timer or of a socket operation):
+/// the connection waits for it without blocking the I/O thread.
+/// The request is valid until the response is sent.
+template <typename Handler>
+dynamic_content get_async(Handler&& _handler)
+{
+  return dynamic_content::asynchronous("GET", make_async_handler(std::forward<Handler>(_handler)));
+}
+
+template <typename Handler>
+dynamic_content post_async(Handler&& _handler)
+{
+  return dynamic_content::asynchronous("POST", make_async_handler(std::forward<Handler>(_handler)));
+}
+
+template <typename Handler>
+dynamic_content put_async(Handler&& _handler)
+{
+  return dynamic_content::asynchronous("PUT", make_async_handler(std::forward<Handler>(_handler)));
+}
+
+inline dynamic_content post_stream(std::function<body_stream(const request& req)> _stream_handler)
+{
+  return dynamic_content::streaming("POST", _stream_handler);
+}
+
+inline dynamic_content put_stream(std::function<body_stream(const request& req)> _stream_handler)
+{
+  return dynamic_content::streaming("PUT", _stream_handler);
+}
+
 } // namespace f16::http::server
 
 #endif // F16_HTTP_DYNAMIC_CONTENT_HPP
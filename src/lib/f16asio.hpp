@@ -15,4 +15,22 @@
 #include <asio.hpp>
 #endif
 
+namespace f16 {
+
+/// The I/O backend of asio, selected at build time (see the F16_IO_URING cmake option).
+inline constexpr const char* io_backend =
+#if defined(ASIO_HAS_IO_URING_AS_DEFAULT)
+  "io_uring";
+#elif defined(ASIO_HAS_IOCP)
+  "iocp";
+#elif defined(ASIO_HAS_EPOLL)
+  "epoll";
+#elif defined(ASIO_HAS_KQUEUE)
+  "kqueue";
+#else
+  "select";
+#endif
+
+} // namespace f16
+
 #endif // F16_F16ASIO_HPP
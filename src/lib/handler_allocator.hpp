@@ -0,0 +1,136 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_HANDLER_ALLOCATOR_HPP
+#define F16_HTTP_HANDLER_ALLOCATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace f16::http::server {
+
+/// Memory recycled by the completion handlers of a connection.
+/// The operations of a connection follow one another, so a single block
+/// (reused each time) replaces the heap allocation that asio performs for
+/// every asynchronous operation. When the block is busy, or too small, the
+/// memory comes from the heap.
+/// Enabled by the F16_HANDLER_ALLOCATOR compile definition
+/// (see the cmake option with the same name).
+class handler_memory
+{
+public:
+  handler_memory() = default;
+  handler_memory(const handler_memory&) = delete;
+  handler_memory& operator=(const handler_memory&) = delete;
+  ~handler_memory() = default;
+
+  void* allocate(std::size_t size)
+  {
+#ifdef F16_HANDLER_ALLOCATOR
+    if (!in_use_ && size <= sizeof(storage_))
+    {
+      in_use_ = true;
+      return storage_.data();
+    }
+#endif
+    return ::operator new(size);
+  }
+
+  void deallocate(void* pointer)
+  {
+#ifdef F16_HANDLER_ALLOCATOR
+    if (pointer == storage_.data())
+    {
+      in_use_ = false;
+      return;
+    }
+#endif
+    ::operator delete(pointer);
+  }
+
+private:
+#ifdef F16_HANDLER_ALLOCATOR
+  /// Storage space used for handler-based custom memory allocation.
+  alignas(std::max_align_t) std::array<unsigned char, 1024> storage_{};
+
+  /// Whether the handler-based custom allocation storage has been used.
+  bool in_use_ = false;
+#endif
+};
+
+/// The allocator associated to the completion handlers, that gets the
+/// memory from a handler_memory.
+template <typename T>
+class handler_allocator
+{
+public:
+  using value_type = T;
+
+  explicit handler_allocator(handler_memory& mem) : memory_(mem) {}
+
+  template <typename U>
+  handler_allocator(const handler_allocator<U>& other) noexcept : memory_(other.memory_) {} // NOLINT(google-explicit-constructor)
+
+  bool operator==(const handler_allocator& other) const noexcept { return &memory_ == &other.memory_; }
+  bool operator!=(const handler_allocator& other) const noexcept { return &memory_ != &other.memory_; }
+
+  T* allocate(std::size_t n) const
+  {
+    return static_cast<T*>(memory_.allocate(sizeof(T) * n));
+  }
+
+  void deallocate(T* p, std::size_t /*n*/) const
+  {
+    memory_.deallocate(p);
+  }
+
+private:
+  template <typename>
+  friend class handler_allocator;
+
+  /// The underlying memory.
+  handler_memory& memory_;
+};
+
+/// Wrap a completion handler, associating it to a handler_allocator.
+template <typename Handler>
+class custom_alloc_handler
+{
+public:
+  using allocator_type = handler_allocator<Handler>;
+
+  custom_alloc_handler(handler_memory& m, Handler h) : memory_(m), handler_(std::move(h)) {}
+
+  allocator_type get_allocator() const noexcept { return allocator_type(memory_); }
+
+  template <typename... Args>
+  void operator()(Args&&... args)
+  {
+    handler_(std::forward<Args>(args)...);
+  }
+
+private:
+  handler_memory& memory_;
+  Handler handler_;
+};
+
+/// Helper function to wrap a handler object to add custom allocation.
+/// Without F16_HANDLER_ALLOCATOR the handler is left untouched (asio default allocator).
+template <typename Handler>
+inline auto make_custom_alloc_handler(handler_memory& m, Handler h)
+{
+#ifdef F16_HANDLER_ALLOCATOR
+  return custom_alloc_handler<Handler>(m, std::move(h));
+#else
+  static_cast<void>(m);
+  return h;
+#endif
+}
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_HANDLER_ALLOCATOR_HPP
@@ -6,38 +6,281 @@
 #ifndef F16_HTTP_HTTP_REQUEST_HPP
 #define F16_HTTP_HTTP_REQUEST_HPP
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
-#include "header.hpp"
+#include <cctype>
 
 namespace f16::http::server {
 
+/// The methods of a request: the parser classifies them, so that they can
+/// be dispatched without comparing strings. The extension methods are other.
+enum class http_method : std::uint8_t
+{
+  get,
+  head,
+  post,
+  put,
+  delete_,
+  connect,
+  options,
+  trace,
+  patch,
+  other // the name is in http_request::method
+};
+
+/// The headers the server looks up often: the parser indexes them,
+/// so that their lookup costs a single access.
+enum class known_header : std::uint8_t
+{
+  host,
+  connection,
+  content_length,
+  transfer_encoding,
+  content_type,
+  expect,
+  if_none_match,
+  if_modified_since,
+  range,
+  accept_encoding,
+  user_agent,
+  cookie,
+  other // not indexed
+};
+
+/// A header of a request: name and value refer to the request data.
+struct header_view
+{
+  std::string_view name;
+  std::string_view value;
+};
+
 /// A request received from a client.
+/// The method, the uri and the headers are views on the buffer of the
+/// connection that received the request: they are valid only while the
+/// request is handled. A handler that needs them later must copy them.
 struct http_request
 {
-  std::string method;
-  std::string uri;
+  std::string_view method;
+  std::string_view uri;
   int http_version_major;
   int http_version_minor;
-  std::vector<header> headers;
+  std::vector<header_view> headers;
+
+  /// The body, when it's not consumed by a body_reader while it's received.
+  std::string body;
 
-  std::string get_header(const std::string& name) const
+  /// Empty the request, keeping the allocated memory.
+  void clear()
   {
-    auto it = std::find_if(headers.begin(), headers.end(),
-      [&name](const header& h)
-      {
-        std::string header_name = h.name;
-        std::transform(header_name.begin(), header_name.end(), header_name.begin(),
-          [](unsigned char c) -> char { return static_cast<char>(std::tolower(c)); });
+    method = {};
+    uri = {};
+    http_version_major = 0;
+    http_version_minor = 0;
+    headers.clear();
+    body.clear();
+    method_id_ = http_method::other;
+    index_.fill(0);
+    indexed_ = false;
+  }
+
+  /// The method, as an enum (other for the extension methods).
+  http_method method_id() const
+  {
+    // a request built by hand is classified here
+    return method_id_ == http_method::other ? find_method(method) : method_id_;
+  }
+
+  /// Classify the method (called by the parser as soon as it's complete).
+  void index_method() { method_id_ = find_method(method); }
 
-        return header_name == name;
-      }
-    );
+  /// Classify a method name (case sensitive).
+  static http_method find_method(std::string_view name)
+  {
+    switch (name.size())
+    {
+    case 3:
+      if (name == "GET") return http_method::get;
+      if (name == "PUT") return http_method::put;
+      break;
+    case 4:
+      if (name == "HEAD") return http_method::head;
+      if (name == "POST") return http_method::post;
+      break;
+    case 5:
+      if (name == "PATCH") return http_method::patch;
+      if (name == "TRACE") return http_method::trace;
+      break;
+    case 6:
+      if (name == "DELETE") return http_method::delete_;
+      break;
+    case 7:
+      if (name == "OPTIONS") return http_method::options;
+      if (name == "CONNECT") return http_method::connect;
+      break;
+    default:
+      break;
+    }
+    return http_method::other;
+  }
+
+  /// Add the last header of headers to the index, if it's a known header
+  /// (called by the parser as soon as the name is complete).
+  void index_last_header()
+  {
+    indexed_ = true;
+    const auto id = find_known_header(headers.back().name);
+    if (id == known_header::other)
+      return;
+    auto& position = index_[static_cast<std::size_t>(id)];
+    // the first one wins, as in the lookup by name
+    if (position == 0)
+      position = static_cast<std::uint16_t>(headers.size());
+  }
+
+  /// Classify a header name (case insensitive).
+  static known_header find_known_header(std::string_view name)
+  {
+    for (std::size_t i = 0; i < known_names.size(); ++i)
+      if (iequals(name, known_names[i]))
+        return static_cast<known_header>(i);
+    return known_header::other;
+  }
+
+  /// Move the views, when the data of the request is moved by offset bytes.
+  void relocate(std::ptrdiff_t offset)
+  {
+    auto move = [offset](std::string_view& v)
+    {
+      if (!v.empty())
+        v = std::string_view(v.data() + offset, v.size());
+    };
+    move(method);
+    move(uri);
+    for (auto& h : headers)
+    {
+      move(h.name);
+      move(h.value);
+    }
+  }
+
+  /// Tell whether a known header is present (even with an empty value).
+  bool has_header(known_header id) const
+  {
+    if (id == known_header::other)
+      return false;
+    if (!indexed_)
+      return find_if_header(known_names[static_cast<std::size_t>(id)]) != headers.end();
+    return index_[static_cast<std::size_t>(id)] != 0;
+  }
+
+  /// Get the value of a known header.
+  /// Return an empty value if the header is missing.
+  std::string_view get_header(known_header id) const
+  {
+    if (id == known_header::other)
+      return {};
+    if (!indexed_)
+      return find_header(known_names[static_cast<std::size_t>(id)]);
+    const auto position = index_[static_cast<std::size_t>(id)];
+    return position == 0 ? std::string_view{} : headers[position - 1U].value;
+  }
+
+  /// Get the value of a header, given its name (case insensitive).
+  /// Return an empty value if the header is missing.
+  std::string_view get_header(std::string_view name) const
+  {
+    if (indexed_)
+    {
+      const auto id = find_known_header(name);
+      if (id != known_header::other)
+        return get_header(id);
+    }
+    return find_header(name);
+  }
+
+  /// Tell whether the client asked to keep the connection open after the reply.
+  /// HTTP/1.1 connections are persistent unless the client sends "Connection: close",
+  /// HTTP/1.0 connections are persistent only with "Connection: keep-alive".
+  bool keep_alive() const
+  {
+    const std::string_view connection = get_header(known_header::connection);
+    const bool http11 = http_version_major > 1 || (http_version_major == 1 && http_version_minor >= 1);
+    if (http11)
+      return !has_token(connection, "close");
+    return has_token(connection, "keep-alive");
+  }
+
+  /// Tell whether the client waits for "100 Continue" before sending the body
+  /// ("Expect: 100-continue", ignored for HTTP/1.0 clients).
+  bool expects_continue() const
+  {
+    const bool http11 = http_version_major > 1 || (http_version_major == 1 && http_version_minor >= 1);
+    return http11 && has_token(get_header(known_header::expect), "100-continue");
+  }
+
+private:
+
+  /// The names of the known headers, in the order of known_header.
+  static constexpr std::array<std::string_view, static_cast<std::size_t>(known_header::other)> known_names{
+    "host", "connection", "content-length", "transfer-encoding", "content-type", "expect",
+    "if-none-match", "if-modified-since", "range", "accept-encoding", "user-agent", "cookie"
+  };
+
+  /// Look for a header in headers, by name.
+  std::string_view find_header(std::string_view name) const
+  {
+    auto it = find_if_header(name);
     if (it != headers.end())
       return it->value;
     return {};
   }
+
+  /// Look for a header in headers, by name: return its iterator.
+  std::vector<header_view>::const_iterator find_if_header(std::string_view name) const
+  {
+    return std::find_if(headers.begin(), headers.end(),
+      [&name](const header_view& h) { return iequals(h.name, name); });
+  }
+
+  http_method method_id_ = http_method::other;
+
+  /// Position + 1 in headers of the first header of each known_header (0 = missing).
+  std::array<std::uint16_t, static_cast<std::size_t>(known_header::other)> index_{};
+
+  /// Whether the headers have been indexed by the parser (otherwise, as when
+  /// the request is built by hand, the lookups scan the headers).
+  bool indexed_ = false;
+
+  /// Compare two strings, ignoring the case.
+  static bool iequals(std::string_view a, std::string_view b)
+  {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+        [](char x, char y) { return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y)); });
+  }
+
+  /// Check if the comma separated list contains the token (case insensitive).
+  static bool has_token(std::string_view list, std::string_view token)
+  {
+    std::size_t pos = 0;
+    while (pos <= list.size())
+    {
+      std::size_t end = list.find(',', pos);
+      if (end == std::string_view::npos)
+        end = list.size();
+      std::size_t first = list.find_first_not_of(" \t", pos);
+      std::size_t last = list.find_last_not_of(" \t", end - 1);
+      if (first != std::string_view::npos && first < end && last - first + 1 == token.size()
+          && iequals(list.substr(first, token.size()), token))
+        return true;
+      pos = end + 1;
+    }
+    return false;
+  }
 };
 
 } // namespace f16::http::server
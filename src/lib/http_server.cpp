@@ -5,14 +5,89 @@
 
 #include "http_server.hpp"
 #include "plain_connection.hpp"
+#include "reply.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
 #include <utility>
 
 namespace f16::http::server {
 
-http_server::http_server(asio::io_context& ioc)
+namespace {
+
+/// A connection closed after its reply, discarding the data of the client
+/// until it closes its side, or until the deadline.
+/// Closing a socket with unread data makes the kernel send a reset instead
+/// of a FIN, and the client could drop the reply still in its buffers.
+class lingering_close : public std::enable_shared_from_this<lingering_close>
+{
+public:
+  explicit lingering_close(asio::ip::tcp::socket socket)
+    : socket_(std::move(socket)), deadline_(socket_.get_executor())
+  {
+  }
+
+  void start(std::chrono::milliseconds linger)
+  {
+    deadline_.expires_after(linger);
+    deadline_.async_wait([self = shared_from_this()](std::error_code ec) {
+      if (ec != asio::error::operation_aborted)
+        self->close();
+    });
+    do_read();
+  }
+
+private:
+  void do_read()
+  {
+    socket_.async_read_some(asio::buffer(buffer_), [self = shared_from_this()](std::error_code ec, std::size_t) {
+      if (ec)
+        self->close();
+      else
+        self->do_read();
+    });
+  }
+
+  void close()
+  {
+    asio::error_code ignored_ec;
+    deadline_.cancel();
+    socket_.close(ignored_ec);
+  }
+
+  asio::ip::tcp::socket socket_;
+  asio::steady_timer deadline_;
+  std::array<char, 512> buffer_{};
+};
+
+} // namespace
+
+http_server::http_server(asio::io_context& ioc, const server_settings& settings)
   : io_context_(ioc),
-    acceptor_(io_context_)
+    acceptor_(io_context_),
+    accept_executor_(settings.strand_per_connection ?
+      asio::any_io_executor(asio::make_strand(io_context_)) :
+      asio::any_io_executor(io_context_.get_executor())),
+    timers_(settings.timer_resolution),
+    tick_timer_(io_context_),
+    settings_(settings),
+    connection_pool_(settings.connection_pool_size)
+#if defined(ASIO_HAS_CO_AWAIT)
+    , coro_connection_pool_(settings.connection_pool_size)
+#endif
 {
+#if !defined(ASIO_HAS_CO_AWAIT)
+  if (settings_.coroutine_connections)
+    throw std::runtime_error("Coroutine connections require C++20");
+#endif
+  connection_manager_.on_stop([this]() { resume_accept(); });
+  if (settings_.worker_threads != 0)
+  {
+    workers_ = std::make_unique<worker_pool>(settings_.worker_threads, settings_.worker_queue_limit);
+    request_handler_.set_workers(workers_.get());
+  }
 }
 
 http_server::~http_server()
@@ -35,15 +110,38 @@ void http_server::listen(const std::string& port, const std::string& address)
     *resolver.resolve(address, port).begin();
   acceptor_.open(endpoint.protocol());
   acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+  if (settings_.reuse_port)
+  {
+#if defined(SO_REUSEPORT)
+    using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    acceptor_.set_option(reuse_port(true));
+#else
+    throw std::runtime_error("SO_REUSEPORT is not supported on this platform");
+#endif
+  }
   acceptor_.bind(endpoint);
   acceptor_.listen();
+  acceptor_.non_blocking(true);
 
-  do_accept();
+  for (std::size_t i = 0; i < std::max<std::size_t>(settings_.concurrent_accepts, 1); ++i)
+    do_accept();
+
+  tick_timer_.expires_after(timers_.resolution());
+  do_tick();
+}
+
+asio::any_io_executor http_server::connection_executor()
+{
+  // The new socket (and so all the handlers of its connection) runs on
+  // a strand when several threads run the io_context.
+  if (settings_.strand_per_connection)
+    return asio::make_strand(io_context_);
+  return io_context_.get_executor();
 }
 
 void http_server::do_accept()
 {
-  acceptor_.async_accept(
+  acceptor_.async_accept(connection_executor(), asio::bind_executor(accept_executor_,
     [this](std::error_code ec, asio::ip::tcp::socket socket)
     {
       // Check whether the server was stopped by a signal before this
@@ -53,19 +151,161 @@ void http_server::do_accept()
         return;
       }
 
+      if (ec == asio::error::operation_aborted)
+      {
+        // cancelled by another accept that reached the limit
+        pause_accept();
+        return;
+      }
+
       if (!ec)
       {
-        connection_manager_.start(create_connection(
-            std::move(socket), connection_manager_, request_handler_));
+        if (settings_.overload == overload_policy::pause && at_connection_limit())
+          deferred_.push_back(std::move(socket)); // accepted along with the one reaching the limit
+        else
+          admit(std::move(socket));
+      }
+
+      // Drain the connections already queued by the kernel, without
+      // a reactor round trip for each one (the acceptor is non-blocking).
+      for (std::size_t i = 0; i < settings_.accept_batch; ++i)
+      {
+        if (settings_.overload == overload_policy::pause && at_connection_limit())
+          break;
+        asio::error_code accept_ec;
+        asio::ip::tcp::socket s = acceptor_.accept(connection_executor(), accept_ec);
+        if (accept_ec)
+          break; // would_block: the queue is empty
+        admit(std::move(s));
+      }
+
+      if (settings_.overload == overload_policy::pause && at_connection_limit())
+      {
+        // the other outstanding accepts must stop as well
+        asio::error_code ignored_ec;
+        acceptor_.cancel(ignored_ec);
+        pause_accept();
+        return;
       }
 
       do_accept();
+    }));
+}
+
+void http_server::pause_accept()
+{
+  // leave the new connections in the kernel backlog until some
+  // connection closes (resume_accept is also polled at each tick,
+  // in case of races and of connections closed by other servers)
+  ++paused_accepts_;
+  accept_paused_ = true;
+}
+
+void http_server::admit(asio::ip::tcp::socket socket)
+{
+  if (settings_.overload == overload_policy::reject && at_connection_limit())
+    reject_connection(std::move(socket));
+  else
+    connection_manager_.start(create_connection(
+        std::move(socket), connection_manager_, request_handler_, settings_, timers_));
+}
+
+bool http_server::at_connection_limit() const
+{
+  return (settings_.max_connections != 0 && connection_manager_.size() >= settings_.max_connections) ||
+    (settings_.max_total_connections != 0 && connection_manager::total_size() >= settings_.max_total_connections);
+}
+
+void http_server::resume_accept()
+{
+  if (!accept_paused_)
+    return;
+
+  const auto low_water = [this](std::size_t limit) { return limit * settings_.low_water_percent / 100; };
+  if (settings_.max_connections != 0 && connection_manager_.size() > low_water(settings_.max_connections))
+    return;
+  if (settings_.max_total_connections != 0 && connection_manager::total_size() > low_water(settings_.max_total_connections))
+    return;
+
+  // only one thread can resume, then the accepts restart from their executor
+  if (accept_paused_.exchange(false))
+    asio::post(accept_executor_, [this]() {
+      auto it = deferred_.begin();
+      for (; it != deferred_.end() && !at_connection_limit(); ++it)
+        admit(std::move(*it));
+      deferred_.erase(deferred_.begin(), it);
+      if (settings_.overload == overload_policy::pause && at_connection_limit())
+      {
+        accept_paused_ = true;
+        return;
+      }
+      for (; paused_accepts_ > 0; --paused_accepts_)
+        do_accept();
+    });
+}
+
+void http_server::reject_connection(asio::ip::tcp::socket socket)
+{
+  static const std::string overloaded = []() {
+    reply rep = reply::stock_reply(reply::service_unavailable);
+    rep.headers.push_back({"Connection", "close"});
+    std::string s;
+    for (const auto& b : rep.to_buffers())
+      s.append(static_cast<const char*>(b.data()), b.size());
+    return s;
+  }();
+
+  // best effort, without waiting: the reply fits in the socket send buffer
+  asio::error_code ec;
+  socket.non_blocking(true, ec);
+  socket.write_some(asio::buffer(overloaded), ec);
+  socket.shutdown(asio::ip::tcp::socket::shutdown_send, ec);
+  if (ec || settings_.reject_linger.count() <= 0)
+  {
+    socket.close(ec);
+    return;
+  }
+  // the request of the client is still unread: wait for the client to close
+  std::make_shared<lingering_close>(std::move(socket))->start(settings_.reject_linger);
+}
+
+void http_server::do_tick()
+{
+  tick_timer_.async_wait(
+    [this](std::error_code ec)
+    {
+      if (ec == asio::error::operation_aborted || !acceptor_.is_open())
+        return;
+
+      timers_.advance(asio::steady_timer::clock_type::now());
+      resume_accept();
+      tick_timer_.expires_at(tick_timer_.expiry() + timers_.resolution());
+      do_tick();
     });
 }
 
-connection_ptr http_server::create_connection(asio::ip::tcp::socket socket, connection_manager& cm, request_handler& rh)
+connection_ptr http_server::create_connection(asio::ip::tcp::socket socket, connection_manager& cm, request_handler& rh,
+    const server_settings& settings, timer_wheel& timers)
+{
+#if defined(ASIO_HAS_CO_AWAIT)
+  if (settings.coroutine_connections)
+    return coro_connection_pool_.acquire(std::move(socket), cm, rh, settings, timers);
+#endif
+  return connection_pool_.acquire(std::move(socket), cm, rh, settings, timers);
+}
+
+worker_pool_stats http_server::worker_stats() const
+{
+  return workers_ ? workers_->stats() : worker_pool_stats{};
+}
+
+connection_pool_stats http_server::pool_stats() const
 {
-  return std::make_shared<plain_connection>(std::move(socket), cm, rh);
+#if defined(ASIO_HAS_CO_AWAIT)
+  if (settings_.coroutine_connections)
+    return coro_connection_pool_.stats();
+#endif
+  return connection_pool_.stats();
 }
 
 } // namespace f16::http::server
@@ -7,9 +7,18 @@
 #define F16_HTTP_HTTP_SERVER_HPP
 
 #include "f16asio.hpp"
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 #include "connection_manager.hpp"
+#include "connection_pool.hpp"
+#include "coro_connection.hpp"
+#include "plain_connection.hpp"
 #include "request_handler.hpp"
+#include "server_settings.hpp"
+#include "timer_wheel.hpp"
+#include "worker_pool.hpp"
 
 namespace f16::http::server {
 
@@ -22,7 +31,7 @@ public:
   http_server& operator=(const http_server&) = delete;
 
   /// Construct the server
-  explicit http_server(asio::io_context& ioc);
+  explicit http_server(asio::io_context& ioc, const server_settings& settings = {});
 
   /// Cancel all outstanding asynchronous operations.
   /// Once all operations have finished the destructor will exit.
@@ -38,15 +47,47 @@ public:
   /// Start to listen on the specified TCP address and port
   /// For IPv4, try address: 0.0.0.0
   /// For IPv6, try address: 0::0
+  /// With server_settings::reuse_port, several servers (e.g., one for each
+  /// io_context of an io_context_pool) can listen on the same address.
   void listen(const std::string& port = "80", const std::string& address = "0.0.0.0");
 
+  /// Get the hit/miss counters of the connection pool.
+  [[nodiscard]] virtual connection_pool_stats pool_stats() const;
+
+  /// Get the counters of the worker pool of the offloaded handlers (all zero without a pool).
+  [[nodiscard]] worker_pool_stats worker_stats() const;
+
 protected:
 
-  virtual connection_ptr create_connection(asio::ip::tcp::socket socket, connection_manager& cm, request_handler& rh);
+  virtual connection_ptr create_connection(asio::ip::tcp::socket socket, connection_manager& cm, request_handler& rh,
+      const server_settings& settings, timer_wheel& timers);
+
+  /// Turn away a connection over the limits (overload_policy::reject):
+  /// send a pre-built "503 Service Unavailable" and close (gracefully,
+  /// see server_settings::reject_linger).
+  virtual void reject_connection(asio::ip::tcp::socket socket);
 
 private:
   /// Perform an asynchronous accept operation.
   void do_accept();
+
+  /// Start a connection on the socket, or reject it when over the limits.
+  void admit(asio::ip::tcp::socket socket);
+
+  /// The executor for the handlers of a new connection.
+  asio::any_io_executor connection_executor();
+
+  /// Advance the timer wheel at each tick.
+  void do_tick();
+
+  /// Whether the connections have reached the limits of the settings.
+  [[nodiscard]] bool at_connection_limit() const;
+
+  /// Suspend the current accept operation, because of the connection limits.
+  void pause_accept();
+
+  /// Start accepting again, if paused and the connections went below the low-water mark.
+  void resume_accept();
   
   /// The io_context used to perform asynchronous operations.
   asio::io_context& io_context_;
@@ -54,11 +95,43 @@ private:
   /// Acceptor used to listen for incoming connections.
   asio::ip::tcp::acceptor acceptor_;
 
+  /// Serializes the accept handlers (a strand when several threads run the io_context).
+  asio::any_io_executor accept_executor_;
+
+  /// The timeouts of all the connections (they can outlive it).
+  timer_wheel timers_;
+
+  /// Drives timers_.
+  asio::steady_timer tick_timer_;
+
   /// The connection manager which owns all live connections.
   connection_manager connection_manager_;
 
   /// The handler for all incoming requests.
   request_handler request_handler_;
+
+  /// The settings shared by all the connections.
+  const server_settings settings_;
+
+  /// The recycled connection objects.
+  connection_pool<plain_connection> connection_pool_;
+#if defined(ASIO_HAS_CO_AWAIT)
+  connection_pool<coro_connection> coro_connection_pool_;
+#endif
+
+  /// Whether do_accept() is suspended because of the connection limits.
+  std::atomic<bool> accept_paused_{ false };
+
+  /// Number of the outstanding accepts suspended (only used by accept_executor_).
+  std::size_t paused_accepts_ = 0;
+
+  /// The connections accepted over the limits, to be started when
+  /// resuming (only used by accept_executor_).
+  std::vector<asio::ip::tcp::socket> deferred_;
+
+  /// The threads of the offloaded handlers (declared last, so that they're
+  /// stopped before the rest of the server goes away).
+  std::unique_ptr<worker_pool> workers_;
 };
 
 } // namespace f16::http::server
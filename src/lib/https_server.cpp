@@ -10,9 +10,10 @@
 namespace f16::http::server
 {
 
-https_server::https_server(asio::io_context& ioc, const ssl_settings& ssl_s)
-  : http_server{ ioc }
+https_server::https_server(asio::io_context& ioc, const ssl_settings& ssl_s, const server_settings& settings)
+  : http_server{ ioc, settings }
   , ssl_context_{ asio::ssl::context::tlsv13 }
+  , connection_pool_{ settings.connection_pool_size }
 {
   ssl_context_.set_options(
     asio::ssl::context::default_workarounds |
@@ -53,9 +54,21 @@ https_server::https_server(asio::io_context& ioc, const ssl_settings& ssl_s)
     SSL_CTX_set_timeout(ssl_context_.native_handle(), ssl_s.session_timeout_secs);
 }
 
-connection_ptr https_server::create_connection(asio::ip::tcp::socket socket, connection_manager& cm, request_handler& rh)
+connection_ptr https_server::create_connection(asio::ip::tcp::socket socket, connection_manager& cm, request_handler& rh,
+    const server_settings& settings, timer_wheel& timers)
 {
-  return std::make_shared<ssl_connection>(std::move(socket), cm, rh, ssl_context_);
+  return connection_pool_.acquire(std::move(socket), cm, rh, settings, timers, ssl_context_);
+}
+
+void https_server::reject_connection(asio::ip::tcp::socket socket)
+{
+  asio::error_code ec;
+  socket.close(ec);
+}
+
+connection_pool_stats https_server::pool_stats() const
+{
+  return connection_pool_.stats();
 }
 
 } // namespace f16::http::server
@@ -9,6 +9,7 @@
 #include <asio/ssl.hpp>
 #include <unordered_set>
 #include "http_server.hpp"
+#include "ssl_connection.hpp"
 
 namespace f16::http::server {
 
@@ -46,15 +47,24 @@ public:
   https_server& operator=(const https_server&) = delete;
 
   /// Construct the server
-  https_server(asio::io_context& ioc, const ssl_settings& ssl_s);
+  https_server(asio::io_context& ioc, const ssl_settings& ssl_s, const server_settings& settings = {});
+
+  [[nodiscard]] connection_pool_stats pool_stats() const override;
 
 protected:
 
-  connection_ptr create_connection(asio::ip::tcp::socket socket, connection_manager& cm, request_handler& rh) override;
+  connection_ptr create_connection(asio::ip::tcp::socket socket, connection_manager& cm, request_handler& rh,
+      const server_settings& settings, timer_wheel& timers) override;
+
+  /// A plain text reply cannot be sent before the TLS handshake: just close.
+  void reject_connection(asio::ip::tcp::socket socket) override;
 
 private:
 
   asio::ssl::context ssl_context_;
+
+  /// The recycled connection objects.
+  connection_pool<ssl_connection> connection_pool_;
 };
 
 } // namespace f16::http::server
@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "io_context_pool.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace f16::http::server {
+
+io_context_pool::io_context_pool(std::size_t pool_size, threading_model model)
+  : threads_(pool_size == 0 ? std::max(1U, std::thread::hardware_concurrency()) : pool_size)
+{
+  if (model == threading_model::shared)
+  {
+    io_contexts_.push_back(std::make_unique<asio::io_context>(static_cast<int>(threads_)));
+    work_.push_back(asio::make_work_guard(*io_contexts_.back()));
+    return;
+  }
+
+  // Each io_context is run by exactly one thread: tell asio it can skip locking.
+  for (std::size_t i = 0; i < threads_; ++i)
+  {
+    io_contexts_.push_back(std::make_unique<asio::io_context>(1));
+    work_.push_back(asio::make_work_guard(*io_contexts_.back()));
+  }
+}
+
+void io_context_pool::run(const error_handler& on_error)
+{
+  // The current thread runs the first io_context, the other threads
+  // get the io_contexts in turn.
+  auto run_one = [&on_error](asio::io_context& ioc) {
+    while (true)
+    {
+      try
+      {
+        ioc.run();
+        break; // run() exited normally
+      }
+      catch (const std::exception& e)
+      {
+        if (on_error)
+          on_error(e);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < threads_; ++i)
+    threads.emplace_back([&run_one, &ioc = *io_contexts_[i % io_contexts_.size()]]() { run_one(ioc); });
+
+  run_one(*io_contexts_.front());
+
+  for (auto& t : threads)
+    t.join();
+}
+
+void io_context_pool::stop()
+{
+  work_.clear();
+  for (auto& ioc : io_contexts_)
+    ioc->stop();
+}
+
+} // namespace f16::http::server
@@ -0,0 +1,77 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_IO_CONTEXT_POOL_HPP
+#define F16_HTTP_IO_CONTEXT_POOL_HPP
+
+#include "f16asio.hpp"
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace f16::http::server {
+
+/// How the threads of an io_context_pool share the work.
+enum class threading_model
+{
+  /// Each thread runs its own io_context, that is meant to own its servers
+  /// and connections (shared-nothing), so that the handlers never need to
+  /// synchronize.
+  per_worker,
+
+  /// All the threads run a single io_context. The servers must serialize
+  /// the handlers of each connection (see server_settings::strand_per_connection).
+  shared
+};
+
+/// A pool of threads running io_context objects.
+class io_context_pool
+{
+public:
+  using error_handler = std::function<void(const std::exception&)>;
+
+  io_context_pool(const io_context_pool&) = delete;
+  io_context_pool& operator=(const io_context_pool&) = delete;
+
+  /// Construct the pool with the given number of threads
+  /// (0 means one for each hardware thread).
+  explicit io_context_pool(std::size_t pool_size, threading_model model = threading_model::per_worker);
+
+  /// Run all io_context objects in the pool, and wait for them to finish.
+  /// The exceptions escaping from a handler are notified to on_error and
+  /// the io_context is run again.
+  void run(const error_handler& on_error = {});
+
+  /// Stop all io_context objects in the pool.
+  void stop();
+
+  /// Number of io_context in the pool.
+  [[nodiscard]] std::size_t size() const { return io_contexts_.size(); }
+
+  /// Number of threads running the io_contexts.
+  [[nodiscard]] std::size_t threads() const { return threads_; }
+
+  /// Get the i-th io_context of the pool.
+  asio::io_context& operator[](std::size_t i) { return *io_contexts_[i]; }
+
+private:
+  /// Number of threads running the io_contexts.
+  std::size_t threads_;
+
+  using io_context_ptr = std::unique_ptr<asio::io_context>;
+  using work_guard = asio::executor_work_guard<asio::io_context::executor_type>;
+
+  /// The pool of io_contexts.
+  std::vector<io_context_ptr> io_contexts_;
+
+  /// The work that keeps the io_contexts running.
+  std::list<work_guard> work_;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_IO_CONTEXT_POOL_HPP
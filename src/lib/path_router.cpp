@@ -7,59 +7,354 @@
 #include "http_request.hpp"
 #include "url.hpp"
 #include "reply.hpp"
+#include "body_reader.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 
 namespace f16::http::server {
 
+/// The cache of the routes of a thread: a set associative cache of the
+/// last paths requested, replacing the least recently used path of a set.
+class path_router::route_cache
+{
+public:
+  struct slot
+  {
+    std::uint64_t used = 0; // when the slot has been used last (0 = empty)
+    std::size_t hash = 0;
+    http_method method = http_method::other;
+    std::string raw_path;
+    std::string path; // decoded
+    std::size_t entry = 0;
+    path_params params; // views on path
+  };
+
+  explicit route_cache(std::size_t capacity) :
+    sets((capacity + ways - 1) / ways),
+    slots(sets * ways)
+  {
+  }
+
+  /// Routes of the router generation are cached.
+  std::uint64_t generation = 0;
+
+  // written by the thread of the cache only, read by cache_stats()
+  std::atomic<std::uint64_t> hits{ 0 };
+  std::atomic<std::uint64_t> misses{ 0 };
+
+  const slot* find(http_method method, std::string_view raw_path)
+  {
+    const std::size_t h = hash(method, raw_path);
+    for (slot* s = first_of_set(h); s != first_of_set(h) + ways; ++s)
+    {
+      if (s->used != 0 && s->hash == h && s->method == method && s->raw_path == raw_path)
+      {
+        s->used = ++clock;
+        increment(hits);
+        return s;
+      }
+    }
+    increment(misses);
+    return nullptr;
+  }
+
+  void insert(http_method method, std::string_view raw_path, std::string_view path, std::size_t entry, const route_pattern* pattern)
+  {
+    const std::size_t h = hash(method, raw_path);
+    slot* victim = first_of_set(h);
+    for (slot* s = victim; s != first_of_set(h) + ways; ++s)
+      if (s->used < victim->used)
+        victim = s;
+
+    victim->used = ++clock;
+    victim->hash = h;
+    victim->method = method;
+    victim->raw_path.assign(raw_path);
+    victim->path.assign(path);
+    victim->entry = entry;
+    victim->params.clear();
+    if (pattern != nullptr)
+      pattern->match(victim->path, victim->params);
+  }
+
+  /// Drop all the routes.
+  void reset(std::uint64_t _generation)
+  {
+    for (slot& s : slots)
+      s.used = 0;
+    generation = _generation;
+  }
+
+private:
+  static constexpr std::size_t ways = 4;
+
+  static std::size_t hash(http_method method, std::string_view raw_path)
+  {
+    const std::size_t h = std::hash<std::string_view>{}(raw_path);
+    return h ^ (static_cast<std::size_t>(method) + 0x9e3779b9U + (h << 6U) + (h >> 2U));
+  }
+
+  static void increment(std::atomic<std::uint64_t>& counter)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  slot* first_of_set(std::size_t h) { return &slots[(h % sets) * ways]; }
+
+  std::size_t sets;
+  std::vector<slot> slots;
+  std::uint64_t clock = 0;
+};
+
+/// The caches of the threads using a router.
+struct path_router::cache_registry
+{
+  explicit cache_registry(std::size_t _capacity) : capacity(_capacity) {}
+
+  const std::uint64_t id = next_generation();
+  const std::size_t capacity;
+  std::mutex mutex;
+  std::vector<std::shared_ptr<route_cache>> caches;
+};
+
+std::uint64_t path_router::next_generation()
+{
+  static std::atomic<std::uint64_t> last{ 0 };
+  return ++last;
+}
+
+void path_router::enable_cache(std::size_t capacity)
+{
+  if (capacity == 0)
+    caches.reset();
+  else
+    caches = std::make_shared<cache_registry>(capacity);
+}
+
+path_router::cache_statistics path_router::cache_stats() const
+{
+  cache_statistics stats;
+  if (!caches)
+    return stats;
+  std::lock_guard<std::mutex> lock(caches->mutex);
+  for (const auto& c : caches->caches)
+  {
+    stats.hits += c->hits.load(std::memory_order_relaxed);
+    stats.misses += c->misses.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+path_router::route_cache& path_router::local_cache() const
+{
+  // the cache used last by the thread: the registry is alive, so its caches are
+  thread_local std::uint64_t last_id = 0;
+  thread_local route_cache* last = nullptr;
+
+  if (last_id != caches->id)
+  {
+    // the registry owns the caches, they go away with the router
+    thread_local std::unordered_map<std::uint64_t, std::weak_ptr<route_cache>> local;
+    auto& weak = local[caches->id];
+    auto cache = weak.lock();
+    if (!cache)
+    {
+      cache = std::make_shared<route_cache>(caches->capacity);
+      std::lock_guard<std::mutex> lock(caches->mutex);
+      caches->caches.push_back(cache);
+    }
+    weak = cache;
+    last_id = caches->id;
+    last = cache.get();
+  }
+
+  if (last->generation != generation)
+    last->reset(generation);
+  return *last;
+}
+
 void path_router::operator()(const http_request& req, reply& rep) const
+{
+  serve(req, rep, false);
+}
+
+bool path_router::serve_inline(const http_request& req, reply& rep) const
+{
+  return serve(req, rep, true);
+}
+
+bool path_router::serve(const http_request& req, reply& rep, bool offload) const
 {
   /*
   std::cout << "http v. " << req.http_version_major << '.' << req.http_version_minor
             << ' ' << req.method
             << " " << req.uri << std::endl; // TODO remove
   */
-  // Decode url to path.  
-  std::string request_path;
-  if (!url_decode(req.uri, request_path))
+  route_match match;
+  if (!find(req, match))
   {
     rep = reply::stock_reply(reply::bad_request);
-    return;
+    return true;
   }
 
-  // Request path must be absolute and not contain "..".
-  if (request_path.empty() || request_path[0] != '/'
-      || request_path.find("..") != std::string::npos)
-  {
-    rep = reply::stock_reply(reply::bad_request);
-    return;
-  }
+  // the worker thread will find the resource again
+  if (offload && match.entry != nullptr && match.entry->offloaded())
+    return false;
+
+  if (match.entry == nullptr || !match.entry->serve(match, req, rep))
+    rep = reply::stock_reply(reply::not_found);
+  return true;
+}
+
+std::unique_ptr<body_reader> path_router::open_body(const http_request& req) const
+{
+  std::unique_ptr<body_reader> reader;
+
+  // an invalid path is answered by operator()
+  route_match match;
+  if (find(req, match) && match.entry != nullptr)
+    match.entry->open_body(match, req, reader);
+  return reader;
+}
 
+bool path_router::find(const http_request& req, route_match& match) const
+{
   // we don't have handlers for HEAD methods.
   // use GET instead
-  auto method = req.method;
-  if (method == "HEAD")
-    method = "GET";
+  auto method = req.method_id();
+  if (method == http_method::head)
+    method = http_method::get;
 
-  auto it = resources.find(method);
-  if (it == resources.end())
+  const method_routes* routes = nullptr;
+  if (method != http_method::other)
   {
-    rep = reply::stock_reply(reply::not_found);
-    return;
+    routes = &resources[static_cast<std::size_t>(method)];
+  }
+  else
+  {
+    auto it = extension_resources.find(req.method);
+    if (it != extension_resources.end())
+      routes = &it->second;
   }
 
-  // we iterate over all the handlers for this method
-  // to handle the case where path parameters are used
-  // e.g. 
-  //    /greet
-  //    /greet/<name>
-  //    /greet/<name>/<country>
+  const auto raw_query_start = req.uri.find('?');
+  const std::string_view raw_path = req.uri.substr(0, raw_query_start);
+  if (raw_query_start != std::string_view::npos)
+  {
+    // the query is decoded by the handler, if it reads it
+    match.has_query = true;
+    match.query = req.uri.substr(raw_query_start + 1);
+  }
 
-  for (const auto& r: it->second)
+  route_cache* cache = caches && method != http_method::other ? &local_cache() : nullptr;
+  if (cache != nullptr)
+  {
+    if (const auto* hit = cache->find(method, raw_path))
+    {
+      match.entry = &routes->entries[hit->entry];
+      match.path = hit->path;
+      match.params = &hit->params;
+      return !match.has_query || valid_query(match.query);
+    }
+  }
+
+  if (raw_path.find_first_of("%+") == std::string_view::npos)
+  {
+    // nothing to decode: the path is the one of the uri, without copies
+    if (!valid_path(raw_path))
+      return false;
+    match.path = raw_path;
+  }
+  else
+  {
+    if (!request_path(raw_path, match.decoded))
+      return false;
+    const std::string_view decoded{ match.decoded };
+    const auto query_start = decoded.find('?');
+    match.path = decoded.substr(0, query_start);
+    if (query_start != std::string_view::npos)
+    {
+      // a '?' decoded from the path starts the query: it's the first escaped one
+      const auto escape = std::min(raw_path.find("%3F"), raw_path.find("%3f"));
+      match.has_query = true;
+      match.query = req.uri.substr(escape + 3);
+    }
+  }
+  if (match.has_query && !valid_query(match.query))
+    return false;
+  match.params = &match.own_params;
+  if (routes == nullptr)
+    return true;
+
+  // the resource is found by the route tree, among the resources of the
+  // method (e.g., /greet, /greet/:name, /greet/:name/:country), then
+  // the pattern of its location extracts the path parameters
+  const std::size_t id = routes->tree.find(match.path);
+  if (id == route_tree::npos)
+    return true;
+  const resource_entry& entry = routes->entries[id];
+  match.entry = &entry;
+  if (entry.dynamic())
+    entry.pattern.match(match.path, match.own_params);
+
+  // a '?' decoded from the path would start the query
+  if (cache != nullptr && raw_path.find("%3F") == std::string_view::npos && raw_path.find("%3f") == std::string_view::npos)
+    cache->insert(method, raw_path, match.path, id, entry.dynamic() ? &entry.pattern : nullptr);
+  return true;
+}
+
+path_router::method_routes& path_router::routes_of(std::string_view method)
+{
+  const auto id = http_request::find_method(method);
+  if (id != http_method::other)
+    return resources[static_cast<std::size_t>(id)];
+  auto it = extension_resources.find(method);
+  if (it == extension_resources.end())
+    it = extension_resources.emplace(std::string(method), method_routes{}).first;
+  return it->second;
+}
+
+bool path_router::request_path(std::string_view raw_path, std::string& path)
+{
+  // Decode url to path.
+  if (!url_decode(raw_path, path))
+    return false;
+
+  return valid_path(path);
+}
+
+bool path_router::valid_path(std::string_view path)
+{
+  // Request path must be absolute and not contain "..".
+  return !path.empty() && path[0] == '/' && path.find("..") == std::string_view::npos;
+}
+
+bool path_router::valid_query(std::string_view raw_query)
+{
+  // the escapes must be complete and, as for the path, ".." is refused
+  // (also when its dots are escaped)
+  bool dot = false;
+  for (std::size_t i = 0; i < raw_query.size(); ++i)
   {
-    if (r.serve_if_match(request_path, req, rep))
-      return;
+    char c = raw_query[i];
+    if (c == '%')
+    {
+      if (i + 2 >= raw_query.size() || !std::isxdigit(static_cast<unsigned char>(raw_query[i + 1])) ||
+          !std::isxdigit(static_cast<unsigned char>(raw_query[i + 2])))
+        return false;
+      c = raw_query[i + 1] == '2' && (raw_query[i + 2] == 'E' || raw_query[i + 2] == 'e') ? '.' : '%';
+      i += 2;
+    }
+    if (c == '.' && dot)
+      return false;
+    dot = c == '.';
   }
-  rep = reply::stock_reply(reply::not_found);
+  return true;
 }
 
 } // namespace f16::http::server
@@ -6,11 +6,21 @@
 #ifndef F16_HTTP_PATH_ROUTER_HPP
 #define F16_HTTP_PATH_ROUTER_HPP
 
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
-#include <unordered_map>
 #include <variant>
 
+#include "body_reader.hpp"
+#include "http_request.hpp"
+#include "route_pattern.hpp"
+#include "route_tree.hpp"
 #include "static_content.hpp"
 #include "dynamic_content.hpp"
 
@@ -24,22 +34,97 @@ public:
   template<typename T>
   void add(std::string location, T&& resource)
   {
-    auto& handlers = resources[resource.method()];
-    handlers.emplace_back(std::move(location), std::forward<T>(resource));
-    std::sort(handlers.begin(), handlers.end(), [](const resource_entry& a, const resource_entry& b) {
-      return a.location.size() > b.location.size();
-    });
+    auto& routes = routes_of(resource.method());
+    // the static content is served from all the paths under its location
+    routes.tree.add(location, std::is_same_v<std::decay_t<T>, static_content>);
+    routes.entries.emplace_back(std::move(location), std::forward<T>(resource));
+    // the cached routes are not valid anymore
+    generation = next_generation();
   }
 
   void operator()(const http_request& req, reply& rep) const;
 
+  /// Like operator(), unless the resource of the request runs on the worker
+  /// pool (see dynamic_content::offload): return false then, leaving rep untouched.
+  bool serve_inline(const http_request& req, reply& rep) const;
+
+  /// Get the consumer of the body of a request, when its resource streams
+  /// the body (nullptr if the body must be collected in the request).
+  std::unique_ptr<body_reader> open_body(const http_request& req) const;
+
+  /// Remember the resources of the last requests, by method and path, so that
+  /// the requests of the same paths skip the decoding of the path and the
+  /// search of the resource. Each thread has its own cache, holding up to
+  /// capacity paths (0 disables the cache). The paths that don't match any
+  /// resource, and the extension methods, are not cached.
+  /// Must be called before handling the requests.
+  void enable_cache(std::size_t capacity);
+
+  /// The hits and the misses of the cache, on all the threads.
+  struct cache_statistics
+  {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+
+    [[nodiscard]] double hit_rate() const
+    {
+      return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+    }
+  };
+  [[nodiscard]] cache_statistics cache_stats() const;
+
 private:
 
+  /// Decode the path of the request (without the query), checking that it's valid.
+  static bool request_path(std::string_view raw_path, std::string& path);
+
+  /// Check a decoded path: it must be absolute and not contain "..".
+  static bool valid_path(std::string_view path);
+
+  /// Check the query of the request, without decoding it.
+  static bool valid_query(std::string_view raw_query);
+
+  /// A new value for generation, never used before by any router.
+  static std::uint64_t next_generation();
+
+  struct resource_entry;
+  struct method_routes;
+  class route_cache;
+  struct cache_registry;
+
+  /// The resources of a method (created, for an extension method).
+  method_routes& routes_of(std::string_view method);
+
+  /// The resource of a request, with the parts of its uri.
+  struct route_match
+  {
+    const resource_entry* entry = nullptr;
+    std::string_view path; // without the query, decoded
+    std::string_view query; // not decoded (see query_string)
+    bool has_query = false;
+    const path_params* params = nullptr;
+    // the storage of path and params, when they're not in the cache
+    // (a path without escapes is a view on the uri, it's not decoded)
+    std::string decoded;
+    path_params own_params;
+  };
+
+  /// Find the resource of a request (match.entry is nullptr if none).
+  /// Return false if the uri is not valid.
+  bool find(const http_request& req, route_match& match) const;
+
+  /// Serve the request, unless its resource is offloaded and offload is true.
+  bool serve(const http_request& req, reply& rep, bool offload) const;
+
+  /// The cache of the calling thread.
+  route_cache& local_cache() const;
+
   struct resource_entry
   {
     template <typename Handler>
     resource_entry(std::string l, Handler&& h) :
       location(std::move(l)),
+      pattern(location),
       handler(std::in_place_type<std::decay_t<Handler>>, std::forward<Handler>(h))
     {
       static_assert(std::disjunction<
@@ -48,22 +133,63 @@ private:
         "Invalid handler type passed to resource_entry");      
     }
 
-    bool serve_if_match(const std::string& resource_path, const http_request& req, reply& rep) const
+    [[nodiscard]] bool dynamic() const { return std::holds_alternative<dynamic_content>(handler); }
+
+    [[nodiscard]] bool offloaded() const
+    {
+      const auto* content = std::get_if<dynamic_content>(&handler);
+      return content != nullptr && content->is_offloaded();
+    }
+
+    bool serve(const route_match& match, const http_request& req, reply& rep) const
     {
       return std::visit(
         [&](auto&& _handler) {
-          return _handler.serve_if_match(location, resource_path, req, rep);
+          if constexpr (std::is_same_v<std::decay_t<decltype(_handler)>, dynamic_content>)
+          {
+            _handler.serve(*match.params, match.query, req, rep);
+            return true;
+          }
+          else
+          {
+            std::string resource_path{match.path};
+            if (match.has_query)
+              resource_path.append(1, '?').append(match.query);
+            return _handler.serve_if_match(location, resource_path, req, rep);
+          }
         },
         handler);
     }
 
+    void open_body(const route_match& match, const http_request& req, std::unique_ptr<body_reader>& reader) const
+    {
+      if (const auto* content = std::get_if<dynamic_content>(&handler))
+        content->open_body(*match.params, match.query, req, reader);
+    }
+
     std::string location;
+    /// The location compiled once, for the dynamic content.
+    route_pattern pattern;
   private:
     std::variant<static_content, dynamic_content> handler;
   };
 
-  // method -> list of resource_entry sorted by location length (desc)
-  std::unordered_map<std::string, std::vector<resource_entry>> resources;
+  /// The resources of a method.
+  struct method_routes
+  {
+    std::vector<resource_entry> entries; // indexed by the id in tree
+    route_tree tree;
+  };
+
+  // known method -> resources
+  std::array<method_routes, static_cast<std::size_t>(http_method::other)> resources;
+  // extension method -> resources
+  std::map<std::string, method_routes, std::less<>> extension_resources;
+
+  // identifies the routes, for the cache
+  std::uint64_t generation = next_generation();
+  // the caches of the threads (nullptr when the cache is disabled)
+  std::shared_ptr<cache_registry> caches;
 };
 
 } // namespace f16::http::server
@@ -12,13 +12,21 @@
 namespace f16::http::server {
 
 plain_connection::plain_connection(asio::ip::tcp::socket socket,
-    connection_manager& manager, request_handler& handler)
-  : base_connection(std::move(socket), manager, handler)
+    connection_manager& manager, request_handler& handler,
+    const server_settings& settings, timer_wheel& timers)
+  : base_connection(std::move(socket), manager, handler, settings, timers)
 {
 }
 
+void plain_connection::reset(asio::ip::tcp::socket socket)
+{
+  socket_.emplace(std::move(socket));
+  reset_state();
+}
+
 void plain_connection::start()
 {
+  set_timeout(timeout_phase::header);
   do_read();
 }
 
@@ -23,9 +23,13 @@ public:
 
   /// Construct a plain_connection with the given socket.
   explicit plain_connection(asio::ip::tcp::socket socket,
-      connection_manager& manager, request_handler& handler);
+      connection_manager& manager, request_handler& handler,
+      const server_settings& settings, timer_wheel& timers);
 
   void start() override;
+
+  /// Bind the connection to a new client, reusing its buffers.
+  void reset(asio::ip::tcp::socket socket);
 };
 
 } // namespace f16::http::server
@@ -0,0 +1,59 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "query_string.hpp"
+#include "url.hpp"
+
+namespace f16::http::server {
+
+std::vector<std::string_view> query_string::get_all(std::string_view name) const
+{
+  const path_params& params = parsed();
+  std::vector<std::string_view> values;
+  for (std::size_t i = 0; i < params.size(); ++i)
+    if (params[i].first == name)
+      values.push_back(params[i].second);
+  return values;
+}
+
+void query_string::parse() const
+{
+  parsed_ = true;
+  std::string_view rest = raw_;
+  while (!rest.empty())
+  {
+    const auto end = rest.find('&');
+    const std::string_view item = rest.substr(0, end);
+    rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+    if (item.empty())
+      continue;
+    const auto equal = item.find('=');
+    if (equal == std::string_view::npos)
+      params_.add(decode(item), {});
+    else
+      params_.add(decode(item.substr(0, equal)), decode(item.substr(equal + 1)));
+  }
+}
+
+std::string_view query_string::decode(std::string_view text) const
+{
+  if (text.find_first_of("%+") == std::string_view::npos)
+    return text;
+
+  // the decodings are never longer than the query: reserving it once,
+  // the views on decoded_ stay valid
+  if (decoded_.capacity() < raw_.size())
+    decoded_.reserve(raw_.size());
+  const std::size_t start = decoded_.size();
+  if (!url_decode_append(text, decoded_))
+  {
+    // malformed escape: as it was received
+    decoded_.resize(start);
+    return text;
+  }
+  return std::string_view(decoded_).substr(start);
+}
+
+} // namespace f16::http::server
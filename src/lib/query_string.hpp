@@ -0,0 +1,92 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_QUERY_STRING_HPP
+#define F16_HTTP_QUERY_STRING_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "route_pattern.hpp"
+
+namespace f16::http::server {
+
+/// The query string of a request (e.g., "name=daniele&tag=a&tag=b"), kept as
+/// it arrives and split in parameters the first time one is read, so that the
+/// handlers that don't read it pay nothing.
+/// The names and the values are views: on the query when they're not encoded,
+/// otherwise on their decoding, stored in a buffer of the query_string (allocated
+/// once, only when a parameter has escapes). They are valid only while the
+/// request is handled.
+/// It's not thread safe: it's read by the handler of the request only.
+class query_string
+{
+public:
+  using param = path_params::param;
+
+  query_string() = default;
+
+  /// The query, without the '?' (not copied: it must outlive the query_string).
+  explicit query_string(std::string_view raw) : raw_(raw) {}
+
+  /// A copy parses the query again (the views of the parameters are not copied).
+  query_string(const query_string& other) : raw_(other.raw_) {}
+
+  query_string& operator=(const query_string& other)
+  {
+    if (this != &other)
+    {
+      raw_ = other.raw_;
+      parsed_ = false;
+      params_.clear();
+      decoded_.clear();
+    }
+    return *this;
+  }
+
+  ~query_string() = default;
+
+  /// The query, as it was received.
+  [[nodiscard]] std::string_view raw() const { return raw_; }
+
+  /// Get the value of a parameter (empty if it's missing).
+  /// When a name is repeated, the last one wins.
+  [[nodiscard]] std::string_view get(std::string_view name) const { return parsed().get(name); }
+
+  /// Get all the values of a parameter, in order (e.g., "a", "b" for "tag=a&tag=b").
+  [[nodiscard]] std::vector<std::string_view> get_all(std::string_view name) const;
+
+  [[nodiscard]] bool contains(std::string_view name) const { return parsed().contains(name); }
+
+  /// Number of parameters (the repeated ones are counted each time).
+  [[nodiscard]] std::size_t size() const { return parsed().size(); }
+  [[nodiscard]] bool empty() const { return parsed().empty(); }
+
+  /// The i-th parameter of the query, as a name/value pair.
+  const param& operator[](std::size_t i) const { return parsed()[i]; }
+
+private:
+  const path_params& parsed() const
+  {
+    if (!parsed_)
+      parse();
+    return params_;
+  }
+
+  void parse() const;
+
+  /// Decode text in decoded_, if it has escapes.
+  std::string_view decode(std::string_view text) const;
+
+  std::string_view raw_;
+  mutable bool parsed_ = false;
+  mutable path_params params_;
+  mutable std::string decoded_;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_QUERY_STRING_HPP
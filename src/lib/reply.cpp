@@ -11,47 +11,55 @@ namespace f16::http::server {
 
 namespace status_strings {
 
+static const std::string continue_ = // NOLINT
+  "HTTP/1.1 100 Continue\r\n";
 static const std::string ok = // NOLINT
-  "HTTP/1.0 200 OK\r\n";
+  "HTTP/1.1 200 OK\r\n";
 static const std::string created = // NOLINT
-  "HTTP/1.0 201 Created\r\n";
+  "HTTP/1.1 201 Created\r\n";
 static const std::string accepted = // NOLINT
-  "HTTP/1.0 202 Accepted\r\n";
+  "HTTP/1.1 202 Accepted\r\n";
 static const std::string no_content = // NOLINT
-  "HTTP/1.0 204 No Content\r\n";
+  "HTTP/1.1 204 No Content\r\n";
 static const std::string multiple_choices = // NOLINT
-  "HTTP/1.0 300 Multiple Choices\r\n";
+  "HTTP/1.1 300 Multiple Choices\r\n";
 static const std::string moved_permanently = // NOLINT
-  "HTTP/1.0 301 Moved Permanently\r\n";
+  "HTTP/1.1 301 Moved Permanently\r\n";
 static const std::string moved_temporarily = // NOLINT
-  "HTTP/1.0 302 Moved Temporarily\r\n";
+  "HTTP/1.1 302 Moved Temporarily\r\n";
 static const std::string not_modified = // NOLINT
-  "HTTP/1.0 304 Not Modified\r\n";
+  "HTTP/1.1 304 Not Modified\r\n";
 static const std::string bad_request = // NOLINT
-  "HTTP/1.0 400 Bad Request\r\n";
+  "HTTP/1.1 400 Bad Request\r\n";
 static const std::string unauthorized = // NOLINT
-  "HTTP/1.0 401 Unauthorized\r\n";
+  "HTTP/1.1 401 Unauthorized\r\n";
 static const std::string forbidden = // NOLINT
-  "HTTP/1.0 403 Forbidden\r\n";
+  "HTTP/1.1 403 Forbidden\r\n";
 static const std::string not_found = // NOLINT
-  "HTTP/1.0 404 Not Found\r\n";
+  "HTTP/1.1 404 Not Found\r\n";
+static const std::string payload_too_large = // NOLINT
+  "HTTP/1.1 413 Payload Too Large\r\n";
+static const std::string request_header_fields_too_large = // NOLINT
+  "HTTP/1.1 431 Request Header Fields Too Large\r\n";
 static const std::string internal_server_error = // NOLINT
-  "HTTP/1.0 500 Internal Server Error\r\n";
+  "HTTP/1.1 500 Internal Server Error\r\n";
 static const std::string not_implemented = // NOLINT
-  "HTTP/1.0 501 Not Implemented\r\n";
+  "HTTP/1.1 501 Not Implemented\r\n";
 static const std::string bad_gateway = // NOLINT
-  "HTTP/1.0 502 Bad Gateway\r\n";
+  "HTTP/1.1 502 Bad Gateway\r\n";
 static const std::string service_unavailable = // NOLINT
-  "HTTP/1.0 503 Service Unavailable\r\n";
+  "HTTP/1.1 503 Service Unavailable\r\n";
 static const std::string gateway_timeout = // NOLINT
-  "HTTP/1.0 504 Gateway Timeout\r\n";
+  "HTTP/1.1 504 Gateway Timeout\r\n";
 static const std::string http_version_not_supported = // NOLINT
-  "HTTP/1.0 505 HTTP Version Not Supported\r\n";
+  "HTTP/1.1 505 HTTP Version Not Supported\r\n";
 
 static asio::const_buffer to_buffer(reply::status_type status)
 {
   switch (status)
   {
+  case reply::continue_:
+    return asio::buffer(continue_);
   case reply::ok:
     return asio::buffer(ok);
   case reply::created:
@@ -76,6 +84,10 @@ static asio::const_buffer to_buffer(reply::status_type status)
     return asio::buffer(forbidden);
   case reply::not_found:
     return asio::buffer(not_found);
+  case reply::payload_too_large:
+    return asio::buffer(payload_too_large);
+  case reply::request_header_fields_too_large:
+    return asio::buffer(request_header_fields_too_large);
   case reply::internal_server_error:
     return asio::buffer(internal_server_error);
   case reply::not_implemented:
@@ -176,6 +188,16 @@ static const std::string not_found = // NOLINT
   "<head><title>Not Found</title></head>"
   "<body><h1>404 Not Found</h1></body>"
   "</html>";
+static const std::string payload_too_large = // NOLINT
+  "<html>"
+  "<head><title>Payload Too Large</title></head>"
+  "<body><h1>413 Payload Too Large</h1></body>"
+  "</html>";
+static const std::string request_header_fields_too_large = // NOLINT
+  "<html>"
+  "<head><title>Request Header Fields Too Large</title></head>"
+  "<body><h1>431 Request Header Fields Too Large</h1></body>"
+  "</html>";
 static const std::string internal_server_error = // NOLINT
   "<html>"
   "<head><title>Internal Server Error</title></head>"
@@ -235,6 +257,10 @@ static std::string to_string(reply::status_type status)
     return forbidden;
   case reply::not_found:
     return not_found;
+  case reply::payload_too_large:
+    return payload_too_large;
+  case reply::request_header_fields_too_large:
+    return request_header_fields_too_large;
   case reply::internal_server_error:
     return internal_server_error;
   case reply::not_implemented:
@@ -277,6 +303,8 @@ reply::status_type reply::status_from_string(const std::string& s)
     {"unauthorized", reply::unauthorized},
     {"forbidden", reply::forbidden},
     {"not_found", reply::not_found},
+    {"payload_too_large", reply::payload_too_large},
+    {"request_header_fields_too_large", reply::request_header_fields_too_large},
     {"internal_server_error", reply::internal_server_error},
     {"not_implemented", reply::not_implemented},
     {"bad_gateway", reply::bad_gateway},
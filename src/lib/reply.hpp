@@ -6,6 +6,8 @@
 #ifndef F16_HTTP_REPLY_HPP
 #define F16_HTTP_REPLY_HPP
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include "f16asio.hpp"
@@ -13,6 +15,8 @@
 
 namespace f16::http::server {
 
+class async_reply;
+
 /// A reply to be sent to a client.
 struct reply
 {
@@ -63,6 +67,7 @@ struct reply
   /// The status of the reply.
   enum status_type
   {
+    continue_ = 100, // interim reply, sent before reading the body (see http_request::expects_continue)
     ok = 200,
     created = 201,
     accepted = 202,
@@ -75,6 +80,8 @@ struct reply
     unauthorized = 401,
     forbidden = 403,
     not_found = 404,
+    payload_too_large = 413,
+    request_header_fields_too_large = 431,
     internal_server_error = 500,
     not_implemented = 501,
     bad_gateway = 502,
@@ -89,6 +96,26 @@ struct reply
   /// The content to be sent in the reply.
   std::string content;
 
+  /// What a chunk_source tells about the next piece of the content.
+  enum class chunk_status
+  {
+    more, // chunk has been filled
+    pending, // the piece is not ready: resume will be called when it is
+    done // the content is over
+  };
+
+  /// When set, the content is produced a piece at a time and sent with
+  /// "Transfer-Encoding: chunked" (after content, if not empty).
+  /// It's called again only when the previous piece has been sent, to fill
+  /// chunk with the next piece. When the piece is not ready, it returns
+  /// pending and keeps a copy of resume, to call it (once, from any thread)
+  /// when the piece can be produced: then it's called again.
+  std::function<chunk_status(std::string& chunk, const std::function<void()>& resume)> chunk_source;
+
+  /// When set, the reply is produced by an asynchronous handler (see get_async):
+  /// the connection starts it, and waits for the reply without blocking.
+  std::shared_ptr<async_reply> async;
+
   /// Convert the reply into a vector of buffers. The buffers do not own the
   /// underlying memory blocks, therefore the reply object must remain valid and
   /// not be changed until the write operation has completed.
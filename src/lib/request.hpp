@@ -7,9 +7,11 @@
 #define F16_HTTP_REQUEST_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 #include "http_request.hpp"
+#include "query_string.hpp"
+#include "route_pattern.hpp"
 // #include <iostream> // TODO remove
 
 namespace f16::http::server {
@@ -18,48 +20,50 @@ namespace f16::http::server {
  * @brief A request passed to the handler.
  * 
  * This structure represents a request that is passed to the handler.
- * It contains the original HTTP request and maps for storing path info and query string parameters.
+ * It contains the original HTTP request, the parameters of the path and the query string.
  */
 struct request
 {
   /**
    * @brief The original HTTP request.
    * 
-   * This is the original HTTP request that was received.
+   * This is the original HTTP request that was received (not copied:
+   * it's valid only while the request is handled).
    */
-  const http_request orig_request;
+  const http_request& orig_request;
 
   /**
-   * @brief A map of path info: key -> value.
+   * @brief The parameters of the path: key -> value.
    * 
-   * This map stores information about the path, where each key corresponds to a part of the path.
+   * Each key corresponds to a parameter of the location (e.g., "id" for "/user/:id").
+   * The keys and the values are views, valid only while the request is handled.
    */
-  std::unordered_map<std::string, std::string> resources;
+  path_params resources;
 
   /**
-   * @brief A map of query string parameters: key -> value.
+   * @brief The query string parameters: key -> value.
    * 
-   * This map stores the query string parameters of the request.
+   * The query is parsed (and decoded) when a parameter is read for the first time.
+   * The keys and the values are views, valid only while the request is handled.
    */
-  std::unordered_map<std::string, std::string> querystring;
+  query_string querystring;
 
   /**
    * @brief Constructs a request with the original HTTP request.
    * 
    * @param r The original HTTP request.
    */
-  explicit request(http_request r) : orig_request{std::move(r)} {}
+  explicit request(const http_request& r) : orig_request{r} {}
 
-  
   /**
-   * @brief Adds a query value to the querystring map.
-   * 
-   * This function adds a key-value pair to the querystring map.
-   * 
-   * @param key The key for the query parameter.
-   * @param value The value for the query parameter.
+   * @brief Retrieves the body of the request.
+   *
+   * The body is limited by server_settings::max_body_size.
+   * It's empty for the resources that stream the body (see post_stream and put_stream).
+   *
+   * @return The body of the request.
    */
-  void add_queryvalue(const std::string& key, const std::string& value) { querystring[key] = value; }
+  const std::string& body() const { return orig_request.body; }
 
   /**
    * @brief Retrieves a resource by key.
@@ -69,30 +73,35 @@ struct request
    * @param key The key for the resource.
    * @return The value associated with the key, empty string if the key was not found
    */
-  std::string resource(const std::string& key) const
+  std::string resource(std::string_view key) const
   {
-    auto it = resources.find(key);
-    if (it != resources.end()) {
-        return it->second;
-    }
-    return {};
+    return std::string(resources.get(key));
   }
 
   /**
    * @brief Retrieves a query value by key.
    * 
-   * This function retrieves the value associated with the specified key in the querystring map.
+   * This function retrieves the (decoded) value associated with the specified key in the querystring.
+   * When the key is repeated, the last value is returned (see queries for all of them).
    * 
    * @param key The key for the query parameter.
-   * @return The value associated with the key, empty string if the key was not found
+   * @return A view on the value associated with the key (valid only while the request is handled),
+   *         empty if the key was not found
+   */
+  std::string_view query(std::string_view key) const
+  {
+    return querystring.get(key);
+  }
+
+  /**
+   * @brief Retrieves all the query values of a key, in order.
+   * 
+   * @param key The key for the query parameter (e.g., "tag" for "?tag=a&tag=b").
+   * @return Views on the values associated with the key (valid only while the request is handled)
    */
-  std::string query(const std::string& key) const
+  std::vector<std::string_view> queries(std::string_view key) const
   {
-    auto it = querystring.find(key);
-    if (it != querystring.end()) {
-        return it->second;
-    }
-    return {};
+    return querystring.get_all(key);
   }
 };
 
@@ -13,6 +13,16 @@ namespace f16::http::server {
 void request_handler::set(handler_fn handler)
 {
   router = std::move(handler);
+  body_router = nullptr;
+  inline_router = nullptr;
+}
+
+void request_handler::set(path_router handler)
+{
+  auto shared = std::make_shared<const path_router>(std::move(handler));
+  router = [shared](const http_request& req, reply& rep) { (*shared)(req, rep); };
+  body_router = [shared](const http_request& req) { return shared->open_body(req); };
+  inline_router = [shared](const http_request& req, reply& rep) { return shared->serve_inline(req, rep); };
 }
 
 void request_handler::handle_request(const http_request& req, reply& rep) const
@@ -20,4 +30,21 @@ void request_handler::handle_request(const http_request& req, reply& rep) const
   router(req, rep);
 }
 
+bool request_handler::try_handle_request(const http_request& req, reply& rep) const
+{
+  if (workers_ == nullptr || !inline_router)
+  {
+    router(req, rep);
+    return true;
+  }
+  return inline_router(req, rep);
+}
+
+std::unique_ptr<body_reader> request_handler::open_body(const http_request& req) const
+{
+  if (!body_router)
+    return nullptr;
+  return body_router(req);
+}
+
 } // namespace f16::http::server
@@ -9,8 +9,10 @@
 #include <string>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 
 #include "path_router.hpp"
+#include "worker_pool.hpp"
 
 namespace f16::http::server {
 
@@ -24,6 +26,8 @@ class request_handler
 public:
 
   using handler_fn = std::function<void(const http_request& req, reply& rep)>;
+  using body_fn = std::function<std::unique_ptr<body_reader>(const http_request& req)>;
+  using inline_fn = std::function<bool(const http_request& req, reply& rep)>;
 
   request_handler(const request_handler&) = delete;
   request_handler& operator=(const request_handler&) = delete;
@@ -32,11 +36,32 @@ public:
 
   void set(handler_fn handler);
 
+  /// Use a path_router, that can also stream the request bodies.
+  void set(path_router handler);
+
   /// Handle a request and produce a reply.
   void handle_request(const http_request& req, reply& rep) const;
 
+  /// Handle a request and produce a reply, unless its handler must run on the
+  /// worker pool (see dynamic_content::offload): return false then, and leave
+  /// rep untouched (handle_request must be called by a worker thread).
+  bool try_handle_request(const http_request& req, reply& rep) const;
+
+  /// Run the offloaded handlers on workers (nullptr: they run inline).
+  void set_workers(worker_pool* workers) { workers_ = workers; }
+
+  /// The pool of the offloaded handlers (nullptr if none).
+  [[nodiscard]] worker_pool* workers() const { return workers_; }
+
+  /// Get the consumer of the body of a request, as soon as its headers are received.
+  /// When it's nullptr, the body is collected in the request passed to handle_request.
+  std::unique_ptr<body_reader> open_body(const http_request& req) const;
+
 private:
   handler_fn router;
+  body_fn body_router;
+  inline_fn inline_router;
+  worker_pool* workers_ = nullptr;
 };
 
 } // namespace f16::http::server
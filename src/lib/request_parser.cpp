@@ -6,8 +6,90 @@
 #include "request_parser.hpp"
 #include "http_request.hpp"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace f16::http::server {
 
+namespace {
+
+/// Index of the lowest bit set (mask != 0).
+inline unsigned lowest_bit(unsigned mask)
+{
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+} // namespace
+
+const char* request_parser::find_ctl_or(const char* p, const char* end, char delim)
+{
+#if defined(__AVX2__)
+  const __m256i ctl_max32 = _mm256_set1_epi8(0x1f);
+  const __m256i del32 = _mm256_set1_epi8(0x7f);
+  const __m256i delim32 = _mm256_set1_epi8(delim);
+  for (; end - p >= 32; p += 32)
+  {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); // NOLINT
+    // x <= 0x1f (unsigned) <=> min(x, 0x1f) == x
+    const __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(x, ctl_max32), x);
+    const __m256i found = _mm256_or_si256(ctl, _mm256_or_si256(_mm256_cmpeq_epi8(x, del32), _mm256_cmpeq_epi8(x, delim32)));
+    const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(found));
+    if (mask != 0)
+      return p + lowest_bit(mask);
+  }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+  const __m128i ctl_max = _mm_set1_epi8(0x1f);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i delim16 = _mm_set1_epi8(delim);
+  for (; end - p >= 16; p += 16)
+  {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); // NOLINT
+    const __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(x, ctl_max), x);
+    const __m128i found = _mm_or_si128(ctl, _mm_or_si128(_mm_cmpeq_epi8(x, del), _mm_cmpeq_epi8(x, delim16)));
+    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+    if (mask != 0)
+      return p + lowest_bit(mask);
+  }
+#endif
+  return find_ctl_or_scalar(p, end, delim);
+}
+
+const char* request_parser::find_ctl_or_scalar(const char* p, const char* end, char delim)
+{
+  for (; p != end; ++p)
+  {
+    const auto c = static_cast<unsigned char>(*p);
+    if (c <= 31 || c == 127 || *p == delim)
+      return p;
+  }
+  return end;
+}
+
+std::string_view request_parser::simd_scan()
+{
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__) || defined(_M_X64)
+  return "sse2";
+#else
+  return "none";
+#endif
+}
+
 request_parser::request_parser()
   : state_(method_start)
 {
@@ -18,8 +100,55 @@ void request_parser::reset()
   state_ = method_start;
 }
 
-request_parser::result_type request_parser::consume(http_request& req, char input) // NOLINT
+std::tuple<request_parser::result_type, const char*> request_parser::parse_contiguous(http_request& req,
+    const char* begin, const char* end)
 {
+  while (begin != end)
+  {
+    // fast path: append the whole run of plain chars, stopping at the
+    // byte that consume() must see (a delimiter or an invalid char)
+    const char* run_end = begin;
+    switch (state_)
+    {
+    case uri:
+      run_end = find_ctl_or(begin, end, ' ');
+      extend(req.uri, begin, run_end);
+      break;
+    case header_name:
+      while (run_end != end && is_char(*run_end) && !is_ctl(*run_end) && !is_tspecial(*run_end))
+        ++run_end;
+      extend(req.headers.back().name, begin, run_end);
+      break;
+    case header_value:
+      run_end = find_ctl_or(begin, end, '\r');
+      extend(req.headers.back().value, begin, run_end);
+      break;
+    default:
+      break;
+    }
+    begin = run_end;
+    if (begin == end)
+      break;
+
+    result_type result = consume(req, begin++);
+    if (result == good || result == bad)
+      return std::make_tuple(result, begin);
+  }
+  return std::make_tuple(indeterminate, begin);
+}
+
+void request_parser::extend(std::string_view& field, const char* begin, const char* end)
+{
+  const auto size = static_cast<std::size_t>(end - begin);
+  if (field.empty())
+    field = std::string_view(begin, size);
+  else
+    field = std::string_view(field.data(), field.size() + size);
+}
+
+request_parser::result_type request_parser::consume(http_request& req, const char* p) // NOLINT
+{
+  const char input = *p;
   switch (state_)
   {
   case method_start:
@@ -30,12 +159,13 @@ request_parser::result_type request_parser::consume(http_request& req, char inpu
     else
     {
       state_ = method;
-      req.method.push_back(input);
+      extend(req.method, p, p + 1);
       return indeterminate;
     }
   case method:
     if (input == ' ')
     {
+      req.index_method();
       state_ = uri;
       return indeterminate;
     }
@@ -45,7 +175,7 @@ request_parser::result_type request_parser::consume(http_request& req, char inpu
     }
     else
     {
-      req.method.push_back(input);
+      extend(req.method, p, p + 1);
       return indeterminate;
     }
   case uri:
@@ -60,7 +190,7 @@ request_parser::result_type request_parser::consume(http_request& req, char inpu
     }
     else
     {
-      req.uri.push_back(input);
+      extend(req.uri, p, p + 1);
       return indeterminate;
     }
   case http_version_h:
@@ -183,11 +313,7 @@ request_parser::result_type request_parser::consume(http_request& req, char inpu
       state_ = expecting_newline_3;
       return indeterminate;
     }
-    else if (!req.headers.empty() && (input == ' ' || input == '\t'))
-    {
-      state_ = header_lws;
-      return indeterminate;
-    }
+    // the obsolete line folding (a line starting with a space) is refused too (RFC 9112)
     else if (!is_char(input) || is_ctl(input) || is_tspecial(input))
     {
       return bad;
@@ -195,33 +321,14 @@ request_parser::result_type request_parser::consume(http_request& req, char inpu
     else
     {
       req.headers.emplace_back();
-      req.headers.back().name.push_back(input);
+      extend(req.headers.back().name, p, p + 1);
       state_ = header_name;
       return indeterminate;
     }
-  case header_lws:
-    if (input == '\r')
-    {
-      state_ = expecting_newline_2;
-      return indeterminate;
-    }
-    else if (input == ' ' || input == '\t')
-    {
-      return indeterminate;
-    }
-    else if (is_ctl(input))
-    {
-      return bad;
-    }
-    else
-    {
-      state_ = header_value;
-      req.headers.back().value.push_back(input);
-      return indeterminate;
-    }
   case header_name:
     if (input == ':')
     {
+      req.index_last_header();
       state_ = space_before_header_value;
       return indeterminate;
     }
@@ -231,7 +338,7 @@ request_parser::result_type request_parser::consume(http_request& req, char inpu
     }
     else
     {
-      req.headers.back().name.push_back(input);
+      extend(req.headers.back().name, p, p + 1);
       return indeterminate;
     }
   case space_before_header_value:
@@ -256,7 +363,7 @@ request_parser::result_type request_parser::consume(http_request& req, char inpu
     }
     else
     {
-      req.headers.back().value.push_back(input);
+      extend(req.headers.back().value, p, p + 1);
       return indeterminate;
     }
   case expecting_newline_2:
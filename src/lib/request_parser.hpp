@@ -6,12 +6,28 @@
 #ifndef F16_HTTP_REQUEST_PARSER_HPP
 #define F16_HTTP_REQUEST_PARSER_HPP
 
+#include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
+#include <vector>
 
 namespace f16::http::server {
 
 struct http_request;
 
+/// Tell whether the iterator walks through chars stored contiguously in memory.
+template <typename Iterator>
+struct is_contiguous_char_iterator : std::disjunction<
+  std::is_same<Iterator, char*>,
+  std::is_same<Iterator, const char*>,
+  std::is_same<Iterator, std::string::iterator>,
+  std::is_same<Iterator, std::string::const_iterator>,
+  std::is_same<Iterator, std::vector<char>::iterator>,
+  std::is_same<Iterator, std::vector<char>::const_iterator>>
+{
+};
+
 /// Parser for incoming requests.
 class request_parser
 {
@@ -29,22 +45,47 @@ public:
   /// been parsed, bad if the data is invalid, indeterminate when more data is
   /// required. The InputIterator return value indicates how much of the input
   /// has been consumed.
+  /// The fields of req refer to the input, without copying it: the input must be
+  /// contiguous in memory, and the input of each call must follow the input of
+  /// the previous ones (when the data is moved, see http_request::relocate).
+  /// The long runs of plain chars are scanned several bytes at a time.
   template <typename InputIterator>
   std::tuple<result_type, InputIterator> parse(http_request& req,
       InputIterator begin, InputIterator end)
   {
-    while (begin != end)
-    {
-      result_type result = consume(req, *begin++);
-      if (result == good || result == bad)
-        return std::make_tuple(result, begin);
-    }
-    return std::make_tuple(indeterminate, begin);
+    static_assert(is_contiguous_char_iterator<InputIterator>::value,
+        "the request refers to the input, that must be contiguous in memory");
+    if (begin == end)
+      return std::make_tuple(indeterminate, begin);
+    const char* first = &*begin;
+    const auto [result, last] = parse_contiguous(req, first, first + (end - begin));
+    return std::make_tuple(result, begin + (last - first));
   }
 
+  /// Find the first control char (0-31 and 127) or the first delim char in
+  /// [p, end), with the SIMD instructions of the build (see simd_scan).
+  /// These are the bytes that end the uri (with delim = ' ') and the header
+  /// values (with delim = '\r'). The bytes over 127 are plain chars.
+  static const char* find_ctl_or(const char* p, const char* end, char delim);
+
+  /// Like find_ctl_or, a byte at a time.
+  static const char* find_ctl_or_scalar(const char* p, const char* end, char delim);
+
+  /// The SIMD instructions used by find_ctl_or: "avx2", "sse2" or "none"
+  /// (see the F16_AVX2 cmake option).
+  static std::string_view simd_scan();
+
 private:
+  /// Parse the input: the uri and the header names and values are extended
+  /// a run at a time (found with SIMD instructions, when available),
+  /// the delimiters and everything else go through consume().
+  std::tuple<result_type, const char*> parse_contiguous(http_request& req, const char* begin, const char* end);
+
   /// Handle the next character of input.
-  result_type consume(http_request& req, char input);
+  result_type consume(http_request& req, const char* input);
+
+  /// Extend a field of the request with the input [begin, end), that follows it.
+  static void extend(std::string_view& field, const char* begin, const char* end);
 
   /// Check if a byte is an HTTP character.
   static constexpr bool is_char(int c);
@@ -75,7 +116,6 @@ private:
     http_version_minor,
     expecting_newline_1,
     header_line_start,
-    header_lws,
     header_name,
     space_before_header_value,
     header_value,
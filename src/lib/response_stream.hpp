@@ -0,0 +1,260 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_RESPONSE_STREAM_HPP
+#define F16_HTTP_RESPONSE_STREAM_HPP
+
+#include <charconv>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "reply.hpp"
+
+namespace f16 {
+
+/// The response written by a dynamic resource: the content is written with
+/// operator<<, as in a std::ostream, and the manipulators (json, ok, ...)
+/// set the properties of the response.
+/// The content is appended to a string, that is moved into the reply.
+/// Strings and numbers are formatted without iostreams (as a std::ostream
+/// with the default format would do); the other types, and the iostream
+/// manipulators (e.g., std::setw), are written through ostream().
+struct response_stream
+{
+  std::string content_type = "text/plain"; // default
+  http::server::reply::status_type status = http::server::reply::ok; // default status
+
+  using chunk_status = http::server::reply::chunk_status;
+
+  /// Send the rest of the content a piece at a time, as it's produced (Transfer-Encoding: chunked).
+  /// The producer is called each time the previous piece has been sent: it fills
+  /// chunk with the next piece, and returns false when the content is over.
+  /// It runs on the I/O thread of the connection (unless the resource is offloaded,
+  /// see dynamic_content::offload), so it must not wait for its data: a producer
+  /// whose pieces are not always ready uses the other overload.
+  /// What has been written in the stream is sent first.
+  void stream(std::function<bool(std::string& chunk)> _producer)
+  {
+    producer = [p = std::move(_producer)](std::string& chunk, const std::function<void()>& /*resume*/) {
+      return p(chunk) ? chunk_status::more : chunk_status::done;
+    };
+  }
+
+  /// As above, but the producer can tell that the next piece is not ready
+  /// yet: it returns chunk_status::pending, and keeps a copy of resume to
+  /// call it (from any thread) when the piece is ready. Meanwhile the
+  /// connection waits, without calling the producer, up to the handler timeout.
+  void stream(std::function<chunk_status(std::string& chunk, const std::function<void()>& resume)> _producer)
+  {
+    producer = std::move(_producer);
+  }
+
+  std::function<chunk_status(std::string& chunk, const std::function<void()>& resume)> producer;
+
+  response_stream() = default;
+  response_stream(const response_stream&) = delete;
+  response_stream& operator=(const response_stream&) = delete;
+  response_stream(response_stream&&) = delete;
+  response_stream& operator=(response_stream&&) = delete;
+  ~response_stream() = default;
+
+  response_stream& write(const char* data, std::size_t size)
+  {
+    if (formatted())
+      os->write(data, static_cast<std::streamsize>(size));
+    else
+      buffer.append(data, size);
+    return *this;
+  }
+
+  response_stream& put(char c)
+  {
+    if (formatted())
+      os->put(c);
+    else
+      buffer.push_back(c);
+    return *this;
+  }
+
+  response_stream& operator<<(std::string_view s) { return write(s.data(), s.size()); }
+  response_stream& operator<<(const std::string& s) { return write(s.data(), s.size()); }
+  response_stream& operator<<(const char* s) { return *this << std::string_view(s); }
+  response_stream& operator<<(char c) { return put(c); }
+
+  /// The numbers, and the types that can be written in a std::ostream.
+  template <typename T>
+  response_stream& operator<<(const T& value)
+  {
+    if constexpr (std::is_convertible_v<const T&, std::string_view>)
+      return *this << std::string_view(value);
+    else if constexpr (std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>)
+      return put(static_cast<char>(value));
+    else if constexpr (std::is_arithmetic_v<T>)
+    {
+      if (formatted())
+        *os << value;
+      else
+        format(value);
+      return *this;
+    }
+    else
+    {
+      ostream() << value;
+      return *this;
+    }
+  }
+
+  /// The f16 manipulators.
+  response_stream& operator<<(response_stream& (*f)(response_stream&)) { return f(*this); }
+
+  /// The iostream manipulators without arguments (e.g., std::endl, std::hex).
+  response_stream& operator<<(std::ostream& (*f)(std::ostream&))
+  {
+    ostream() << f;
+    return *this;
+  }
+
+  /// A std::ostream writing in the content (created the first time it's needed).
+  std::ostream& ostream()
+  {
+    if (!os)
+    {
+      appender = std::make_unique<string_appender>(buffer);
+      os = std::make_unique<std::ostream>(appender.get());
+    }
+    return *os;
+  }
+
+  /// The content written so far.
+  [[nodiscard]] const std::string& str() const { return buffer; }
+
+  /// Take the content written so far, leaving the stream empty.
+  std::string take() { return std::move(buffer); }
+
+private:
+  /// A stream buffer appending to a string, without buffering.
+  class string_appender : public std::streambuf
+  {
+  public:
+    explicit string_appender(std::string& s) : target(s) {}
+
+  protected:
+    int_type overflow(int_type c) override
+    {
+      if (!traits_type::eq_int_type(c, traits_type::eof()))
+        target.push_back(traits_type::to_char_type(c));
+      return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+      target.append(s, static_cast<std::size_t>(n));
+      return n;
+    }
+
+  private:
+    std::string& target;
+  };
+
+  /// Whether the iostream manipulators have changed the format of ostream(),
+  /// so that everything must be written through it.
+  [[nodiscard]] bool formatted() const
+  {
+    return os && (os->flags() != (std::ios_base::skipws | std::ios_base::dec) || os->width() != 0 || os->precision() != 6);
+  }
+
+  template <typename T>
+  void format(T value)
+  {
+    char text[64];
+    if constexpr (std::is_same_v<T, bool>)
+    {
+      buffer.push_back(value ? '1' : '0');
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+      const auto result = std::to_chars(std::begin(text), std::end(text), value);
+      buffer.append(std::begin(text), result.ptr);
+    }
+    else
+    {
+      // as the default format of std::ostream (%g, 6 digits)
+      const int size = std::snprintf(text, sizeof(text), "%Lg", static_cast<long double>(value));
+      buffer.append(text, static_cast<std::size_t>(size));
+    }
+  }
+
+  std::string buffer;
+  std::unique_ptr<string_appender> appender;
+  std::unique_ptr<std::ostream> os;
+};
+
+// f16 manipolators for response_stream
+inline response_stream& json(response_stream& os) {
+  os.content_type = "application/json";
+  return os;
+}
+
+inline response_stream& xml(response_stream& os) {
+  os.content_type = "application/xml";
+  return os;
+}
+
+inline response_stream& plain(response_stream& os) {
+  os.content_type = "text/plain";
+  return os;
+}
+
+inline response_stream& ok(response_stream& os) {
+  os.status = http::server::reply::ok;
+  return os;
+}
+
+inline response_stream& bad_request(response_stream& os) {
+  os.status = http::server::reply::bad_request;
+  return os;
+}
+
+/// A function writing a response_stream, called with Args before it.
+/// It can be built from a function taking a response_stream& or a
+/// std::ostream& (written through response_stream::ostream()).
+template <typename... Args>
+class response_writer
+{
+public:
+  response_writer() = default;
+
+  template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, response_writer>>>
+  response_writer(F f) // NOLINT(google-explicit-constructor)
+  {
+    if constexpr (std::is_invocable_v<F&, Args..., response_stream&>)
+    {
+      fn = std::move(f);
+    }
+    else
+    {
+      static_assert(std::is_invocable_v<F&, Args..., std::ostream&>,
+        "The function must take a f16::response_stream& or a std::ostream&");
+      fn = [f = std::move(f)](Args... args, response_stream& rs) mutable { f(std::forward<Args>(args)..., rs.ostream()); };
+    }
+  }
+
+  void operator()(Args... args, response_stream& rs) const { fn(std::forward<Args>(args)..., rs); }
+
+  explicit operator bool() const { return static_cast<bool>(fn); }
+
+private:
+  std::function<void(Args..., response_stream&)> fn;
+};
+
+} // namespace f16
+
+#endif // F16_HTTP_RESPONSE_STREAM_HPP
@@ -0,0 +1,76 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "route_pattern.hpp"
+
+namespace f16::http::server {
+
+route_pattern::route_pattern(std::string_view location) :
+  location_(location)
+{
+  std::size_t pos = 0;
+  while (pos < location_.size())
+  {
+    if (location_[pos] == ':')
+    {
+      // the name goes up to the next '/'
+      auto end = location_.find('/', pos + 1);
+      if (end == std::string::npos)
+        end = location_.size();
+      segments_.push_back({ true, pos + 1, end - pos - 1 });
+      pos = end;
+    }
+    else
+    {
+      auto end = location_.find(':', pos);
+      if (end == std::string::npos)
+        end = location_.size();
+      segments_.push_back({ false, pos, end - pos });
+      pos = end;
+    }
+  }
+}
+
+template <typename Param>
+bool route_pattern::match_segments(std::string_view path, Param&& on_param) const
+{
+  const std::string_view location{ location_ };
+  std::size_t pos = 0;
+  for (const segment& s : segments_)
+  {
+    // the path is over, but the pattern is not
+    if (pos == path.size())
+      return false;
+    const auto text = location.substr(s.pos, s.size);
+    if (s.param)
+    {
+      auto end = path.find('/', pos);
+      if (end == std::string_view::npos)
+        end = path.size();
+      on_param(text, path.substr(pos, end - pos));
+      pos = end;
+    }
+    else
+    {
+      if (path.compare(pos, text.size(), text) != 0)
+        return false;
+      pos += text.size();
+    }
+  }
+  return pos == path.size() || (pos + 1 == path.size() && path.back() == '/');
+}
+
+bool route_pattern::match(std::string_view path, path_params& params) const
+{
+  params.clear();
+  return match_segments(path, [&params](std::string_view name, std::string_view value) { params.add(name, value); });
+}
+
+bool route_pattern::match(std::string_view path) const
+{
+  return match_segments(path, [](std::string_view /*name*/, std::string_view /*value*/) {});
+}
+
+} // namespace f16::http::server
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_ROUTE_PATTERN_HPP
+#define F16_HTTP_ROUTE_PATTERN_HPP
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace f16::http::server {
+
+/// The parameters extracted from the path of a request (e.g., "id" -> "123"
+/// for the location "/user/:id"). The names and the values are views on the
+/// location and on the path: they are valid only while the request is handled.
+/// The first parameters are stored inline, without allocations.
+class path_params
+{
+public:
+  static constexpr std::size_t inline_capacity = 8;
+
+  using param = std::pair<std::string_view, std::string_view>;
+
+  void clear()
+  {
+    size_ = 0;
+    more_.clear();
+  }
+
+  void add(std::string_view name, std::string_view value)
+  {
+    if (size_ < inline_capacity)
+      inline_[size_] = { name, value };
+    else
+      more_.emplace_back(name, value);
+    ++size_;
+  }
+
+  /// Get the value of a parameter (empty if it's missing).
+  /// When a name is repeated, the last one wins.
+  [[nodiscard]] std::string_view get(std::string_view name) const
+  {
+    for (std::size_t i = size_; i > 0; --i)
+    {
+      const param& p = (*this)[i - 1];
+      if (p.first == name)
+        return p.second;
+    }
+    return {};
+  }
+
+  [[nodiscard]] bool contains(std::string_view name) const
+  {
+    for (std::size_t i = 0; i < size_; ++i)
+      if ((*this)[i].first == name)
+        return true;
+    return false;
+  }
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  const param& operator[](std::size_t i) const { return i < inline_capacity ? inline_[i] : more_[i - inline_capacity]; }
+
+private:
+  std::array<param, inline_capacity> inline_;
+  std::vector<param> more_;
+  std::size_t size_ = 0;
+};
+
+/// The location of a dynamic resource (e.g., "/user/:id/profile"), split once
+/// in static texts and parameters, so that matching a path does not parse the
+/// location again. A parameter matches the text up to the next '/' of the path.
+/// The path can end with an extra '/'.
+class route_pattern
+{
+public:
+  explicit route_pattern(std::string_view location);
+
+  /// Match path (without the query string) with the pattern: on success,
+  /// params holds the values of the parameters, as views on path.
+  bool match(std::string_view path, path_params& params) const;
+
+  /// Match path, without extracting the parameters.
+  [[nodiscard]] bool match(std::string_view path) const;
+
+  [[nodiscard]] const std::string& location() const { return location_; }
+
+private:
+  template <typename Param>
+  bool match_segments(std::string_view path, Param&& on_param) const;
+
+  struct segment
+  {
+    bool param; // otherwise a static text
+    // the text, or the name of the parameter, in location_
+    std::size_t pos;
+    std::size_t size;
+  };
+
+  std::string location_;
+  std::vector<segment> segments_;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_ROUTE_PATTERN_HPP
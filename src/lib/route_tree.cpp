@@ -0,0 +1,143 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "route_tree.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace f16::http::server {
+
+bool route_tree::better(std::size_t a, std::size_t b) const
+{
+  if (b == npos)
+    return a != npos;
+  if (a == npos)
+    return false;
+  return lengths_[a] > lengths_[b] || (lengths_[a] == lengths_[b] && a < b);
+}
+
+std::size_t route_tree::add(std::string_view location, bool prefix)
+{
+  const std::size_t id = lengths_.size();
+  lengths_.push_back(location.size());
+
+  node* n = &root_;
+  if (better(id, n->best))
+    n->best = id;
+
+  // a prefix is a plain text, a pattern alternates static texts and parameters
+  std::size_t pos = 0;
+  while (pos < location.size())
+  {
+    if (!prefix && location[pos] == ':')
+    {
+      auto end = location.find('/', pos + 1);
+      if (end == std::string_view::npos)
+        end = location.size();
+      if (!n->param)
+      {
+        n->param = std::make_unique<node>();
+        n->param->label = location.substr(pos + 1, end - pos - 1);
+      }
+      n = n->param.get();
+      if (better(id, n->best))
+        n->best = id;
+      pos = end;
+    }
+    else
+    {
+      auto end = prefix ? std::string_view::npos : location.find(':', pos);
+      if (end == std::string_view::npos)
+        end = location.size();
+      n = &insert_static(*n, location.substr(pos, end - pos), id);
+      pos = end;
+    }
+  }
+
+  std::size_t& slot = prefix ? n->mount : n->route;
+  if (better(id, slot))
+    slot = id;
+  return id;
+}
+
+route_tree::node& route_tree::insert_static(node& n, std::string_view text, std::size_t id)
+{
+  node* current = &n;
+  while (!text.empty())
+  {
+    auto child = std::find_if(current->children.begin(), current->children.end(),
+      [&text](const node& c) { return c.label[0] == text[0]; });
+    if (child == current->children.end())
+    {
+      current->children.emplace_back();
+      node& leaf = current->children.back();
+      leaf.label = text;
+      leaf.best = id;
+      return leaf;
+    }
+
+    const auto common = static_cast<std::size_t>(
+      std::mismatch(text.begin(), text.end(), child->label.begin(), child->label.end()).first - text.begin());
+    if (common < child->label.size())
+    {
+      // split the child: the common part becomes its parent
+      node tail = std::move(*child);
+      tail.label.erase(0, common);
+      *child = node{};
+      child->label = text.substr(0, common);
+      child->best = tail.best;
+      child->children.push_back(std::move(tail));
+    }
+    if (better(id, child->best))
+      child->best = id;
+    text.remove_prefix(common);
+    current = &*child;
+  }
+  return *current;
+}
+
+std::size_t route_tree::find(std::string_view path) const
+{
+  std::size_t best = npos;
+  find(root_, path, 0, best);
+  return best;
+}
+
+void route_tree::find(const node& n, std::string_view path, std::size_t pos, std::size_t& best) const
+{
+  // nothing in this subtree can win over what has been found
+  if (!better(n.best, best))
+    return;
+
+  if (better(n.mount, best))
+    best = n.mount;
+  const bool at_end = pos == path.size() || (pos + 1 == path.size() && path[pos] == '/');
+  if (at_end && better(n.route, best))
+    best = n.route;
+  if (pos == path.size())
+    return;
+
+  const auto rest = path.substr(pos);
+  for (const node& child : n.children)
+  {
+    if (child.label[0] == rest[0])
+    {
+      if (rest.compare(0, child.label.size(), child.label) == 0)
+        find(child, path, pos + child.label.size(), best);
+      break;
+    }
+  }
+
+  if (n.param)
+  {
+    // the parameter takes the text up to the next '/' (even none)
+    auto end = path.find('/', pos);
+    if (end == std::string_view::npos)
+      end = path.size();
+    find(*n.param, path, end, best);
+  }
+}
+
+} // namespace f16::http::server
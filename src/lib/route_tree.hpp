@@ -0,0 +1,72 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_ROUTE_TREE_HPP
+#define F16_HTTP_ROUTE_TREE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace f16::http::server {
+
+/// A compressed radix tree of the locations of the resources, to find
+/// the resource of a path without trying all the locations one by one.
+/// A location is either a pattern, matching a whole path, where ":name"
+/// matches any text up to the next '/' (e.g., "/user/:id/profile"), or a
+/// prefix, matching all the paths that start with it (e.g., the mount
+/// point of a directory). The path can end with an extra '/'.
+/// When more locations match, the longest one wins (and, between
+/// locations of the same length, the one added first).
+class route_tree
+{
+public:
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  /// Add a location, returning its id (the ids are assigned in sequence, from 0).
+  std::size_t add(std::string_view location, bool prefix);
+
+  /// Find the location matching path (without the query string).
+  /// Return its id, or npos if no location matches.
+  [[nodiscard]] std::size_t find(std::string_view path) const;
+
+  /// Number of locations in the tree.
+  [[nodiscard]] std::size_t size() const { return lengths_.size(); }
+
+private:
+  struct node
+  {
+    /// The text matched by the node: a static text, or the name of a parameter.
+    std::string label;
+    /// The children starting with a static text (their first chars are different).
+    std::vector<node> children;
+    /// The child matching a parameter.
+    std::unique_ptr<node> param;
+    /// The pattern ending at this node.
+    std::size_t route = npos;
+    /// The prefix ending at this node.
+    std::size_t mount = npos;
+    /// The best location in the subtree, to skip the subtrees that cannot win.
+    std::size_t best = npos;
+  };
+
+  /// Whether location a wins over location b.
+  [[nodiscard]] bool better(std::size_t a, std::size_t b) const;
+
+  /// Add the static text to the subtree of n, returning the node where it ends.
+  node& insert_static(node& n, std::string_view text, std::size_t id);
+
+  void find(const node& n, std::string_view path, std::size_t pos, std::size_t& best) const;
+
+  node root_;
+  /// The length of each location, by id.
+  std::vector<std::size_t> lengths_;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_ROUTE_TREE_HPP
@@ -0,0 +1,109 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_SERVER_SETTINGS_HPP
+#define F16_HTTP_SERVER_SETTINGS_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace f16::http::server {
+
+/// What a server does when it reaches its connection limit.
+enum class overload_policy
+{
+  /// Stop accepting: the new connections wait in the kernel backlog.
+  pause,
+
+  /// Accept, answer "503 Service Unavailable" and close.
+  reject
+};
+
+/// Tunables shared by all the connections of a server.
+struct server_settings
+{
+  /// Keep the connection open after a reply (HTTP/1.1 persistent connections).
+  bool keep_alive = true;
+
+  /// Maximum number of requests served on a single connection (0 = unlimited).
+  std::size_t max_keep_alive_requests = 1000;
+
+  /// Let several acceptors bind the same address (SO_REUSEPORT), so that
+  /// each worker thread can accept its own connections.
+  bool reuse_port = false;
+
+  /// Serialize the handlers of each connection with its own strand.
+  /// Required when the io_context of the server is run by several threads.
+  bool strand_per_connection = false;
+
+  /// Serve the plain (not TLS) connections with coroutines instead of
+  /// callbacks (only available when built with C++20).
+  bool coroutine_connections = false;
+
+  /// Maximum number of idle connection objects kept for reuse (0 = no pooling).
+  std::size_t connection_pool_size = 256;
+
+  /// Maximum size of a request body, in bytes (0 = unlimited): a longer body
+  /// is answered with "413 Payload Too Large" as soon as its length is known.
+  std::size_t max_body_size = 1024 * 1024;
+
+  /// Maximum time to receive the headers of a request, from its first byte
+  /// (or from the accept, for the first request of a connection) (0 = no timeout).
+  std::chrono::milliseconds header_timeout = std::chrono::seconds(10);
+
+  /// Maximum time to receive the body of a request (0 = no timeout).
+  std::chrono::milliseconds body_timeout = std::chrono::seconds(30);
+
+  /// Maximum time to send a reply (0 = no timeout).
+  std::chrono::milliseconds write_timeout = std::chrono::seconds(30);
+
+  /// Maximum time a persistent connection waits for the next request (0 = no timeout).
+  std::chrono::milliseconds keep_alive_timeout = std::chrono::seconds(5);
+
+  /// Maximum time to wait for the reply of an asynchronous or offloaded handler
+  /// (see get_async and dynamic_content::offload) (0 = no timeout).
+  std::chrono::milliseconds handler_timeout = std::chrono::seconds(30);
+
+  /// Granularity of the timeouts.
+  std::chrono::milliseconds timer_resolution = std::chrono::milliseconds(100);
+
+  /// Number of accept operations kept outstanding on the listening socket.
+  std::size_t concurrent_accepts = 4;
+
+  /// Maximum number of connections taken from the accept queue without waiting,
+  /// each time an accept completes (0 = one connection at a time).
+  std::size_t accept_batch = 16;
+
+  /// Maximum number of open connections of the server (0 = unlimited).
+  std::size_t max_connections = 0;
+
+  /// Maximum number of open connections of all the servers of the process (0 = unlimited).
+  std::size_t max_total_connections = 0;
+
+  /// What to do with the new connections over the limits.
+  overload_policy overload = overload_policy::pause;
+
+  /// With overload_policy::reject, how long a rejected connection is kept
+  /// after the 503 reply, discarding what the client sends, before closing it
+  /// (0 = close at once: the unread request makes the kernel reset the
+  /// connection, and the client can lose the reply).
+  std::chrono::milliseconds reject_linger = std::chrono::seconds(1);
+
+  /// A paused server accepts again when its connections (and the total ones)
+  /// go below this percentage of the limits.
+  std::size_t low_water_percent = 90;
+
+  /// Number of threads running the offloaded handlers (see dynamic_content::offload),
+  /// away from the I/O threads (0 = no worker pool: the offloaded handlers run inline).
+  std::size_t worker_threads = 0;
+
+  /// Maximum number of offloaded requests waiting for a worker thread (0 = unlimited):
+  /// the requests beyond the limit are answered with "503 Service Unavailable".
+  std::size_t worker_queue_limit = 1024;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_SERVER_SETTINGS_HPP
@@ -13,20 +13,31 @@ namespace f16::http::server {
 
 ssl_connection::ssl_connection(asio::ip::tcp::socket socket,
     connection_manager& manager, request_handler& handler,
-    asio::ssl::context& ctx)
-  : base_connection({std::move(socket), ctx}, manager, handler) 
+    const server_settings& settings, timer_wheel& timers, asio::ssl::context& ctx)
+  : base_connection({std::move(socket), ctx}, manager, handler, settings, timers),
+    ssl_context_(ctx)
 {
 }
 
+void ssl_connection::reset(asio::ip::tcp::socket socket)
+{
+  // a new TLS session needs a brand new stream
+  socket_.emplace(std::move(socket), ssl_context_);
+  reset_state();
+}
+
 void ssl_connection::start()
 {
+  // the handshake is part of the first request
+  set_timeout(timeout_phase::header);
   do_handshake();
 }
 
 void ssl_connection::do_handshake()
 {
   auto self{this->shared_from_this()};
-  socket_.async_handshake(asio::ssl::stream_base::server,
+  socket_->async_handshake(asio::ssl::stream_base::server,
+      make_custom_alloc_handler(read_memory_,
       [this, self](std::error_code ec)
       {
         if (!ec)
@@ -37,7 +48,7 @@ void ssl_connection::do_handshake()
         {
           connection_manager_.stop(self);
         }
-      });
+      }));
 }
 
 } // namespace f16::http::server
@@ -25,13 +25,20 @@ public:
   /// Construct a connection with the given socket.
   explicit ssl_connection(asio::ip::tcp::socket socket,
       connection_manager& manager, request_handler& handler,
-      asio::ssl::context& ctx);
+      const server_settings& settings, timer_wheel& timers, asio::ssl::context& ctx);
 
   void start() override;
 
+  /// Bind the connection to a new client, reusing its buffers.
+  void reset(asio::ip::tcp::socket socket);
+
 protected:
 
   void do_handshake();
+
+private:
+
+  asio::ssl::context& ssl_context_;
 };
 
 } // namespace f16::http::server
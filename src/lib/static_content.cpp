@@ -42,7 +42,7 @@ bool static_content::serve_if_match(const std::string& location, const std::stri
     {
       // directory w/o trailing slash
       rep = reply::stock_reply(reply::moved_permanently);
-      const header h{"Location", req.uri + '/'};
+      const header h{"Location", std::string(req.uri) + '/'};
       rep.headers.push_back(h);
     }
   }
@@ -52,9 +52,6 @@ bool static_content::serve_if_match(const std::string& location, const std::stri
     serve_file(request_path, rep);
   }
 
-  if (req.method == "HEAD")
-    rep.content.clear();
-
   return true;
 }
 
@@ -113,11 +110,19 @@ void static_content::serve_file(const fs::path& full_path, reply& rep)
 
   const auto extension = full_path.extension();
 
-  // Fill out the reply to be sent to the client.
+  // Fill out the reply to be sent to the client,
+  // reading the whole file at once (a single allocation and read)
+  std::error_code ec;
+  const auto size = fs::file_size(full_path, ec);
+  if (ec)
+  {
+    rep = reply::stock_reply(reply::not_found);
+    return;
+  }
   rep.status = reply::ok;
-  std::array<char, 512> buf; // NOLINT
-  while (is.read(buf.data(), buf.size()).gcount() > 0)
-    rep.content.append(buf.data(), static_cast<long unsigned int>(is.gcount()));
+  rep.content.resize(size);
+  is.read(rep.content.data(), static_cast<std::streamsize>(size));
+  rep.content.resize(static_cast<std::size_t>(is.gcount())); // in case the file shrank
   rep.headers = {
     {"Content-Length", std::to_string(rep.content.size())},
     {"Content-Type", mime_types::extension_to_type(extension.string())}
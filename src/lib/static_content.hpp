@@ -7,6 +7,7 @@
 #define F16_HTTP_STATIC_CONTENT_HPP
 
 #include <string>
+#include <string_view>
 #include <filesystem>
 
 namespace f16::http::server {
@@ -20,7 +21,7 @@ class static_content
 public:
   explicit static_content(std::string _doc_root);
   bool serve_if_match(const std::string& location, const std::string& _request_path, const http_request& req, reply& rep) const;
-  [[nodiscard]] static std::string method() { return "GET"; }
+  [[nodiscard]] static std::string_view method() { return "GET"; }
 
 private:
   static void list_directory(const std::filesystem::path& full_path, reply& rep);
@@ -0,0 +1,146 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "timer_wheel.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace f16::http::server {
+
+timer_wheel::timer_wheel(clock::duration resolution, clock::time_point start)
+  : start_(start),
+    state_(std::make_shared<state>(std::max(resolution, clock::duration(1))))
+{
+}
+
+timer_wheel::~timer_wheel()
+{
+  const std::lock_guard<std::mutex> lock(state_->mutex);
+  for (auto& level : state_->wheel)
+    for (auto& head : level)
+      while (head != nullptr)
+        unlink(*head);
+  state_->size = 0;
+  state_->closed = true;
+}
+
+void timer_wheel::arm(state& s, timer& t, clock::duration timeout)
+{
+  // round up, so that the timer never expires before timeout
+  const auto ticks = (std::max(timeout, clock::duration::zero()) + s.resolution - clock::duration(1)) / s.resolution;
+  // the top level covers 2^32 ticks
+  constexpr std::uint64_t max_ticks = (std::uint64_t{1} << (slot_bits * levels)) - 1;
+
+  const std::lock_guard<std::mutex> lock(s.mutex);
+  t.generation_.fetch_add(1, std::memory_order_relaxed);
+  if (s.closed)
+    return;
+  if (t.list_ != nullptr)
+    unlink(t);
+  else
+    ++s.size;
+  t.expiry_ = s.current_tick + std::clamp<std::uint64_t>(static_cast<std::uint64_t>(ticks), 1, max_ticks);
+  insert(s, t);
+}
+
+void timer_wheel::cancel(state& s, timer& t)
+{
+  const std::lock_guard<std::mutex> lock(s.mutex);
+  t.generation_.fetch_add(1, std::memory_order_relaxed);
+  if (t.list_ == nullptr)
+    return;
+  unlink(t);
+  --s.size;
+}
+
+void timer_wheel::advance(clock::time_point now)
+{
+  const std::lock_guard<std::mutex> lock(state_->mutex);
+  if (now < start_)
+    return;
+  const auto target = static_cast<std::uint64_t>((now - start_) / state_->resolution);
+  if (state_->size == 0)
+  {
+    // nothing to expire: jump ahead
+    state_->current_tick = std::max(state_->current_tick, target);
+    return;
+  }
+  while (state_->current_tick < target)
+    tick();
+}
+
+std::size_t timer_wheel::size() const
+{
+  const std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->size;
+}
+
+void timer_wheel::insert(state& s, timer& t)
+{
+  // the level is given by the distance from the current tick,
+  // the slot by the bits of the expiry time for that level
+  const std::uint64_t delta = t.expiry_ > s.current_tick ? t.expiry_ - s.current_tick : 0;
+  std::size_t level = 0;
+  while (level < levels - 1 && delta >= (std::uint64_t{1} << (slot_bits * (level + 1))))
+    ++level;
+  timer*& head = s.wheel[level][(t.expiry_ >> (slot_bits * level)) & slot_mask];
+
+  t.list_ = &head;
+  t.prev_ = nullptr;
+  t.next_ = head;
+  if (head != nullptr)
+    head->prev_ = &t;
+  head = &t;
+}
+
+void timer_wheel::unlink(timer& t)
+{
+  if (t.prev_ != nullptr)
+    t.prev_->next_ = t.next_;
+  else
+    *t.list_ = t.next_;
+  if (t.next_ != nullptr)
+    t.next_->prev_ = t.prev_;
+  t.list_ = nullptr;
+  t.prev_ = nullptr;
+  t.next_ = nullptr;
+}
+
+void timer_wheel::tick()
+{
+  state& s = *state_;
+  ++s.current_tick;
+
+  // at the start of each range of a level, its timers move to the lower levels
+  for (std::size_t level = 1; level < levels; ++level)
+  {
+    if ((s.current_tick & ((std::uint64_t{1} << (slot_bits * level)) - 1)) != 0)
+      break;
+    cascade(level);
+  }
+
+  timer*& head = s.wheel[0][s.current_tick & slot_mask];
+  while (head != nullptr)
+  {
+    timer& t = *head;
+    unlink(t);
+    --s.size;
+    t.callback_();
+  }
+}
+
+void timer_wheel::cascade(std::size_t level)
+{
+  state& s = *state_;
+  timer*& head = s.wheel[level][(s.current_tick >> (slot_bits * level)) & slot_mask];
+  while (head != nullptr)
+  {
+    timer& t = *head;
+    unlink(t);
+    insert(s, t);
+  }
+}
+
+} // namespace f16::http::server
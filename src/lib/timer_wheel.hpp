@@ -0,0 +1,127 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_TIMER_WHEEL_HPP
+#define F16_HTTP_TIMER_WHEEL_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace f16::http::server {
+
+/// A hierarchical timer wheel, to handle the timeouts of a large number of
+/// connections: arming and cancelling a timer are O(1) and don't allocate.
+/// The time is split in ticks of a fixed resolution. The wheel has 4 levels
+/// of 256 slots each: the first level holds the timers expiring within 256
+/// ticks, each slot of the next levels holds the timers of a range 256 times
+/// wider, that are moved to the lower levels when their range comes near.
+/// The owner must call advance() periodically (e.g., from an asio timer),
+/// to run the callbacks of the expired timers.
+class timer_wheel
+{
+  struct state;
+
+public:
+  using clock = std::chrono::steady_clock;
+
+  /// A timer of a timer_wheel.
+  /// The callback runs within timer_wheel::advance(), with the wheel locked:
+  /// it cannot arm or cancel any timer (typically, it posts the real work
+  /// to an executor). The destructor cancels the timer.
+  /// A timer can outlive its wheel: after the wheel is destroyed, it
+  /// never expires, and arming or cancelling it does nothing.
+  class timer
+  {
+  public:
+    timer(timer_wheel& wheel, std::function<void()> callback) : state_(wheel.state_), callback_(std::move(callback)) {}
+    ~timer() { cancel(); }
+
+    timer(const timer&) = delete;
+    timer& operator=(const timer&) = delete;
+    timer(timer&&) = delete;
+    timer& operator=(timer&&) = delete;
+
+    /// Arm the timer to expire after timeout (rounded up to the next tick).
+    /// If the timer is already armed, it's rescheduled.
+    void arm(clock::duration timeout) { timer_wheel::arm(*state_, *this, timeout); }
+
+    /// Disarm the timer (nothing happens if it's not armed).
+    void cancel() { timer_wheel::cancel(*state_, *this); }
+
+    /// Incremented each time the timer is armed or cancelled: the work
+    /// posted by a callback can tell whether the timer has been armed or
+    /// cancelled again in the meantime.
+    [[nodiscard]] std::uint64_t generation() const { return generation_.load(std::memory_order_relaxed); }
+
+  private:
+    friend class timer_wheel;
+
+    std::shared_ptr<state> state_;
+    std::function<void()> callback_;
+    timer** list_ = nullptr; // the slot, when armed
+    timer* prev_ = nullptr;
+    timer* next_ = nullptr;
+    std::uint64_t expiry_ = 0;
+    std::atomic<std::uint64_t> generation_{ 0 };
+  };
+
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator=(const timer_wheel&) = delete;
+
+  /// Construct a wheel whose time starts at start and advances by resolution.
+  explicit timer_wheel(clock::duration resolution, clock::time_point start = clock::now());
+
+  /// Cancel all the timers still armed (the timers still alive are detached).
+  ~timer_wheel();
+
+  /// Move the time of the wheel forward to now, running the callbacks of
+  /// the timers expired in the meantime.
+  void advance(clock::time_point now);
+
+  /// Number of armed timers.
+  [[nodiscard]] std::size_t size() const;
+
+  /// The duration of a tick.
+  [[nodiscard]] clock::duration resolution() const { return state_->resolution; }
+
+private:
+  static constexpr std::size_t levels = 4;
+  static constexpr std::size_t slot_bits = 8;
+  static constexpr std::size_t slots = 1 << slot_bits;
+  static constexpr std::uint64_t slot_mask = slots - 1;
+
+  /// The wheel data, shared with the timers: a timer can outlive its wheel.
+  struct state
+  {
+    explicit state(clock::duration r) : resolution(r) {}
+    const clock::duration resolution;
+    std::mutex mutex;
+    std::uint64_t current_tick = 0;
+    std::size_t size = 0;
+    bool closed = false;
+
+    /// Each slot is the head of a doubly linked list of timers.
+    std::array<std::array<timer*, slots>, levels> wheel{};
+  };
+
+  static void arm(state& s, timer& t, clock::duration timeout);
+  static void cancel(state& s, timer& t);
+  static void insert(state& s, timer& t);
+  static void unlink(timer& t);
+  void tick();
+  void cascade(std::size_t level);
+
+  const clock::time_point start_;
+  std::shared_ptr<state> state_;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_TIMER_WHEEL_HPP
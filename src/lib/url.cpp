@@ -4,46 +4,45 @@
 // file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include "url.hpp"
-#include <cctype>
-#include <ios>
-#include <sstream>
 
 namespace f16::http::server {
 
-  bool url_decode(const std::string& in, std::string& out)
+  namespace {
+
+    int hex_value(char c)
+    {
+      if (c >= '0' && c <= '9')
+        return c - '0';
+      if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+      return -1;
+    }
+
+  } // namespace
+
+  bool url_decode(std::string_view in, std::string& out)
   {
     out.clear();
     out.reserve(in.size());
+    return url_decode_append(in, out);
+  }
+
+  bool url_decode_append(std::string_view in, std::string& out)
+  {
     for (std::size_t i = 0; i < in.size(); ++i)
     {
       if (in[i] == '%')
       {
-        if (i + 2 < in.size())
-        {
-          char hex[3] = { in[i + 1], in[i + 2], '\0' };
-          if (std::isxdigit(hex[0]) && std::isxdigit(hex[1]))
-          {
-            int value = 0;
-            std::istringstream is(hex);
-            if (is >> std::hex >> value)
-            {
-              out += static_cast<char>(value);
-              i += 2;
-            }
-            else
-            {
-              return false;
-            }
-          }
-          else
-          {
-            return false;
-          }
-        }
-        else
-        {
+        if (i + 2 >= in.size())
           return false;
-        }
+        const int high = hex_value(in[i + 1]);
+        const int low = hex_value(in[i + 2]);
+        if (high < 0 || low < 0)
+          return false;
+        out += static_cast<char>(high * 16 + low);
+        i += 2;
       }
       else if (in[i] == '+')
       {
@@ -58,4 +57,3 @@ namespace f16::http::server {
   }
 
 } // namespace f16::http::server
-
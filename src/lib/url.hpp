@@ -7,6 +7,7 @@
 #define F16_HTTP_URL_HPP
 
 #include <string>
+#include <string_view>
 
 namespace f16::http::server {
 
@@ -22,7 +23,10 @@ namespace f16::http::server {
  * @return true If the decoding is successful.
  * @return false If the decoding fails due to incorrect encoding.
  */
-  bool url_decode(const std::string& in, std::string& out);
+  bool url_decode(std::string_view in, std::string& out);
+
+  /// As url_decode, but the decoded string is appended to out (partially, on failure).
+  bool url_decode_append(std::string_view in, std::string& out);
 
 } // namespace f16::http::server
 
@@ -0,0 +1,24 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace f16::http::server {
+
+worker_pool::worker_pool(std::size_t threads, std::size_t queue_limit)
+  : queue_limit_(queue_limit),
+    pool_(threads == 0 ? std::max(1U, std::thread::hardware_concurrency()) : threads)
+{
+}
+
+worker_pool::~worker_pool()
+{
+  pool_.stop();
+  pool_.join();
+}
+
+} // namespace f16::http::server
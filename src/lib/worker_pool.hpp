@@ -0,0 +1,107 @@
+// Copyright (c) 2024 Daniele Pallastrelli
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef F16_HTTP_WORKER_POOL_HPP
+#define F16_HTTP_WORKER_POOL_HPP
+
+#include "f16asio.hpp"
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace f16::http::server {
+
+/// Counters of a worker_pool.
+struct worker_pool_stats
+{
+  /// Jobs run (or running) on the worker threads.
+  std::size_t accepted = 0;
+
+  /// Jobs refused because the queue was full.
+  std::size_t rejected = 0;
+};
+
+/// A pool of threads running the handlers that block (see dynamic_content::offload),
+/// so that they don't stall the connections served by the I/O threads.
+/// The number of jobs waiting for a thread is bounded.
+class worker_pool
+{
+public:
+  worker_pool(const worker_pool&) = delete;
+  worker_pool& operator=(const worker_pool&) = delete;
+
+  /// Construct the pool with the given number of threads (0 means one for each
+  /// hardware thread), queuing at most queue_limit jobs (0 = unlimited).
+  worker_pool(std::size_t threads, std::size_t queue_limit);
+
+  /// The jobs still queued are dropped, the running ones are waited for.
+  ~worker_pool();
+
+  /// Reserve a place in the queue for a job, unless queue_limit jobs are
+  /// already waiting for a thread: return false then.
+  bool try_reserve()
+  {
+    if (queued_.fetch_add(1, std::memory_order_relaxed) >= queue_limit_ && queue_limit_ != 0)
+    {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      rejected_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    accepted_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /// Run job on a worker thread, in the place reserved by try_reserve.
+  template <typename Job>
+  void post(Job&& job)
+  {
+    asio::post(pool_, [this, job = std::forward<Job>(job)]() mutable {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      job();
+    });
+  }
+
+  /// Run job on a worker thread, also when the queue is full: for the jobs
+  /// of a request already accepted (e.g., the next piece of its reply).
+  template <typename Job>
+  void post_accepted(Job&& job)
+  {
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    accepted_.fetch_add(1, std::memory_order_relaxed);
+    post(std::forward<Job>(job));
+  }
+
+  /// Run job on a worker thread, unless the queue is full: return false then.
+  template <typename Job>
+  bool try_post(Job&& job)
+  {
+    if (!try_reserve())
+      return false;
+    post(std::forward<Job>(job));
+    return true;
+  }
+
+  /// Number of jobs waiting for a thread.
+  [[nodiscard]] std::size_t queued() const { return queued_.load(std::memory_order_relaxed); }
+
+  /// Get the pool counters.
+  [[nodiscard]] worker_pool_stats stats() const
+  {
+    return { accepted_.load(std::memory_order_relaxed), rejected_.load(std::memory_order_relaxed) };
+  }
+
+private:
+  const std::size_t queue_limit_;
+  std::atomic<std::size_t> queued_{ 0 };
+  std::atomic<std::size_t> accepted_{ 0 };
+  std::atomic<std::size_t> rejected_{ 0 };
+
+  /// The threads (declared last, so that they're stopped before the counters go away).
+  asio::thread_pool pool_;
+};
+
+} // namespace f16::http::server
+
+#endif // F16_HTTP_WORKER_POOL_HPP
@@ -4,6 +4,7 @@
 // file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include "f16asio.hpp" // NB: the asio header must be included *before* iostream to avoid sanity check error
+#include <chrono>
 #include <csignal>
 #include <fstream>
 #include <functional>
@@ -16,6 +17,7 @@
 
 #include "http_server.hpp"
 #include "https_server.hpp"
+#include "io_context_pool.hpp"
 
 #include "static_content.hpp"
 
@@ -41,42 +43,170 @@ static f16::http::server::ssl_settings::ssl_proto protocol_from_string(const std
   throw std::invalid_argument("Unknown protocol: " + s);
 }
 
-static void build_simple_server(asio::io_context& ioc, std::vector<std::unique_ptr<http_server>>& server_set, const std::string& root_doc, const std::string& bind_address, int port)
+static threading_model threading_model_from_string(const std::string& s)
+{
+  if (s == "per_worker") return threading_model::per_worker;
+  if (s == "shared") return threading_model::shared;
+  throw std::invalid_argument("Unknown threading model: " + s);
+}
+
+static overload_policy overload_policy_from_string(const std::string& s)
+{
+  if (s == "pause") return overload_policy::pause;
+  if (s == "reject") return overload_policy::reject;
+  throw std::invalid_argument("Unknown overload policy: " + s);
+}
+
+static server_settings default_settings(const io_context_pool& pool)
+{
+  server_settings settings;
+  // per_worker: one acceptor for each io_context on the same port
+  settings.reuse_port = pool.size() > 1;
+  // shared: many threads on the same io_context
+  settings.strand_per_connection = pool.size() == 1 && pool.threads() > 1;
+  return settings;
+}
+
+static std::chrono::milliseconds timeout_from_json(const nlohmann::json& entry, const char* key, std::chrono::milliseconds default_value)
+{
+  if (!entry.contains(key))
+    return default_value;
+  return std::chrono::seconds(entry.at(key).get<long>());
+}
+
+static void build_simple_server(io_context_pool& pool, std::vector<std::unique_ptr<http_server>>& server_set, const std::string& root_doc, const std::string& bind_address, int port)
 {
   spdlog::info("Serving root doc {} on {}:{}", root_doc, bind_address, port);
 
-  auto server = std::make_unique<http_server>(ioc);
+  const server_settings settings = default_settings(pool);
+
+  // each io_context gets its own server (acceptor, connections and router)
+  for (std::size_t i = 0; i < pool.size(); ++i)
+  {
+    auto server = std::make_unique<http_server>(pool[i], settings);
 
-  path_router router;
-  router.add("/", static_content(root_doc));
-  server->set(std::move(router));
-  server->listen(std::to_string(port), bind_address);
+    path_router router;
+    router.add("/", static_content(root_doc));
+    server->set(std::move(router));
+    server->listen(std::to_string(port), bind_address);
 
-  server_set.push_back(std::move(server));
+    server_set.push_back(std::move(server));
+  }
 }
 
-static void build_advanced_server(asio::io_context& ioc, std::vector<std::unique_ptr<http_server>>& server_set, const std::string& cfg_file)
+static nlohmann::json load_config(const std::string& cfg_file)
 {
   std::ifstream ifs(cfg_file);
   if (!ifs)
     throw std::runtime_error{ "Configuration file " + cfg_file + " not found" };
-  const nlohmann::json jcfg = nlohmann::json::parse(ifs,
+  return nlohmann::json::parse(ifs,
     nullptr, // callback
     true, // allow exceptions
     true // ignore_comments
   );
+}
+
+static void configure_server(http_server& server, const nlohmann::json& server_entry, bool verbose)
+{
+  if (server_entry.contains("return"))
+  {
+    const auto& return_section = server_entry.at("return");
+    const std::string status_s = return_section.value("status", "ok");
+    const reply::status_type status = reply::status_from_string(status_s);
+    if (verbose)
+      spdlog::info("  Serving status '{}'", status_s);
+    const auto headers = return_section.value("headers", nlohmann::json::array());
+    server.set(
+      [status, headers](const http_request& req, reply& res) {
+        res = reply::stock_reply(status);
+        for (const auto& header_entry : headers)
+        {
+          std::string name;
+          std::string value;
+          for (auto& [k, v] : header_entry.items())
+          {
+            name = k;
+            value = v;
+          }
 
+          // replace $host and $request_uri
+          if (value.find("$host") != std::string::npos)
+          {
+            std::string host{req.get_header(known_header::host)};
+            if (host.empty())
+            {
+              res = reply::stock_reply(reply::bad_request); // 400
+              res.content = "Missing 'Host' header in the request";
+              res.headers = {
+                { "Content-Length", std::to_string(res.content.size()) },
+                { "Content-Type", mime_types::extension_to_type(".txt") }
+              };
+              return;
+            }
+            if (auto pos = host.find(':'); pos != std::string::npos)
+              host.erase(pos); // Erases everything after the ':' character
+            value.replace(value.find("$host"), 5, host);
+          }
+          if (value.find("$request_uri") != std::string::npos)
+          {
+            value.replace(value.find("$request_uri"), 12, req.uri);
+          }
+          res.headers.push_back({ name, value });
+        }
+      });
+  }
+  else if (server_entry.contains("locations"))
+  {
+    path_router router;
+    for (const auto& location_entry : server_entry.at("locations"))
+    {
+      const std::string root_doc = location_entry.at("root");
+      const std::string path = location_entry.at("location");
+      if (verbose)
+        spdlog::info("  Serving root doc {} at path: {}", root_doc, path);
+      router.add(path, static_content(root_doc));
+    }
+    router.enable_cache(server_entry.value("route_cache_size", std::size_t{ 0 }));
+    server.set(std::move(router));
+  }
+  else if (verbose)
+  {
+    spdlog::warn("No 'return' or 'locations' section found for this server entry: this server will not handle any request");
+  }
+}
+
+static void build_advanced_server(io_context_pool& pool, std::vector<std::unique_ptr<http_server>>& server_set, const nlohmann::json& jcfg)
+{
   for (const auto& server_entry : jcfg.at("servers"))
   {
     const std::string address = server_entry.at("listen_address");
     const bool has_ssl = server_entry.contains("ssl");
     const std::string port = server_entry.value("listen_port", (has_ssl ? "443" : "80"));
     spdlog::info("New {} server listening on {}:{}", (has_ssl ? "https" : "http"), address, port);
-    std::unique_ptr<http_server> server;
+    server_settings settings = default_settings(pool);
+    settings.keep_alive = server_entry.value("keep_alive", settings.keep_alive);
+    settings.max_keep_alive_requests = server_entry.value("max_keep_alive_requests", settings.max_keep_alive_requests);
+    settings.coroutine_connections = server_entry.value("coroutine_connections", settings.coroutine_connections);
+    settings.connection_pool_size = server_entry.value("connection_pool_size", settings.connection_pool_size);
+    settings.max_body_size = server_entry.value("max_body_size", settings.max_body_size);
+    settings.header_timeout = timeout_from_json(server_entry, "header_timeout_secs", settings.header_timeout);
+    settings.body_timeout = timeout_from_json(server_entry, "body_timeout_secs", settings.body_timeout);
+    settings.write_timeout = timeout_from_json(server_entry, "write_timeout_secs", settings.write_timeout);
+    settings.keep_alive_timeout = timeout_from_json(server_entry, "keep_alive_timeout_secs", settings.keep_alive_timeout);
+    settings.handler_timeout = timeout_from_json(server_entry, "handler_timeout_secs", settings.handler_timeout);
+    settings.concurrent_accepts = server_entry.value("concurrent_accepts", settings.concurrent_accepts);
+    settings.accept_batch = server_entry.value("accept_batch", settings.accept_batch);
+    settings.max_connections = server_entry.value("max_connections", settings.max_connections);
+    settings.max_total_connections = jcfg.value("max_total_connections", settings.max_total_connections);
+    settings.overload = overload_policy_from_string(server_entry.value("overload", "pause"));
+    settings.reject_linger = timeout_from_json(server_entry, "reject_linger_secs", settings.reject_linger);
+    settings.low_water_percent = server_entry.value("low_water_percent", settings.low_water_percent);
+    settings.worker_threads = server_entry.value("worker_threads", settings.worker_threads);
+    settings.worker_queue_limit = server_entry.value("worker_queue_limit", settings.worker_queue_limit);
+    ssl_settings ssl_s;
     if (has_ssl)
     {
       const auto& ssl_section = server_entry.at("ssl");
-      ssl_settings ssl_s;
       ssl_s.certificate = ssl_section.value("certificate", "");
       ssl_s.certificate_key = ssl_section.value("certificate_key", "");
       ssl_s.dhparam = ssl_section.value("dhparam", "");
@@ -97,76 +227,20 @@ static void build_advanced_server(asio::io_context& ioc, std::vector<std::unique
       ssl_s.session_timeout_secs = ssl_section.value("session_timeout_secs", -1L);
       ssl_s.session_cache = ssl_section.value("session_cache", false);
       ssl_s.session_cache_size = ssl_section.value("session_cache_size", -1L);
-
-      server = std::make_unique<https_server>(ioc, ssl_s);
     }
-    else
-      server = std::make_unique<http_server>(ioc);
 
-    if (server_entry.contains("return"))
+    // each io_context gets its own server (acceptor, connections and router)
+    for (std::size_t i = 0; i < pool.size(); ++i)
     {
-      const auto& return_section = server_entry.at("return");
-      const std::string status_s = return_section.value("status", "ok");
-      const reply::status_type status = reply::status_from_string(status_s);
-      spdlog::info("  Serving status '{}'", status_s);
-      const auto headers = return_section.value("headers", nlohmann::json::array());
-      server->set(
-        [status, headers](const http_request& req, reply& res) {
-          res = reply::stock_reply(status);
-          for (const auto& header_entry : headers)
-          {
-            std::string name;
-            std::string value;
-            for (auto& [k, v] : header_entry.items())
-            {
-              name = k;
-              value = v;
-            }
-
-            // replace $host and $request_uri
-            if (value.find("$host") != std::string::npos)
-            {
-              std::string host = req.get_header("host");
-              if (host.empty())
-              {
-                res = reply::stock_reply(reply::bad_request); // 400
-                res.content = "Missing 'Host' header in the request";
-                res.headers = {
-                  { "Content-Length", std::to_string(res.content.size()) },
-                  { "Content-Type", mime_types::extension_to_type(".txt") }
-                };
-                return;
-              }
-              if (auto pos = host.find(':'); pos != std::string::npos)
-                host.erase(pos); // Erases everything after the ':' character
-              value.replace(value.find("$host"), 5, host);
-            }
-            if (value.find("$request_uri") != std::string::npos)
-            {
-              value.replace(value.find("$request_uri"), 12, req.uri);
-            }
-            res.headers.push_back({ name, value });
-          }
-        });
+      std::unique_ptr<http_server> server;
+      if (has_ssl)
+        server = std::make_unique<https_server>(pool[i], ssl_s, settings);
+      else
+        server = std::make_unique<http_server>(pool[i], settings);
+      configure_server(*server, server_entry, i == 0);
+      server->listen(port, address);
+      server_set.push_back(std::move(server));
     }
-    else if (server_entry.contains("locations"))
-    {
-      path_router router;
-      for (const auto& location_entry : server_entry.at("locations"))
-      {
-        const std::string root_doc = location_entry.at("root");
-        const std::string path = location_entry.at("location");
-        spdlog::info("  Serving root doc {} at path: {}", root_doc, path);
-        router.add(path, static_content(root_doc));
-      }
-      server->set(std::move(router));
-    }
-    else
-    {
-      spdlog::warn("No 'return' or 'locations' section found for this server entry: this server will not handle any request");
-    }
-    server->listen(port, address);
-    server_set.push_back(std::move(server));
   }
 }
 
@@ -204,6 +278,13 @@ int main(int argc, const char** argv)
       ->check(CLI::PositiveNumber); // the port must be positive
     serve_cmd->add_option("-b,--bind", bind_address, "The binding address [default: 0.0.0.0]");
 
+    // Worker threads, each one with its own io_context (0 = one per hardware thread)
+    std::size_t workers = 1;
+    serve_cmd->add_option("-w,--workers", workers, "The number of worker threads, 0 for one per core [default: 1].");
+    // per_worker: an io_context for each thread, shared: a single io_context run by all the threads
+    std::string threading = "per_worker";
+    serve_cmd->add_option("-t,--threading", threading, "The threading model: per_worker or shared [default: per_worker].");
+
     // --- Subcommand 2: ADVANCED ---
     CLI::App* config_cmd = app.add_subcommand("config", "Start the server using a configuration file.");
     std::string config_path;
@@ -212,21 +293,34 @@ int main(int argc, const char** argv)
     config_cmd->add_option("config_path", config_path, "Configurazione file path.")
       ->required()
       ->check(CLI::ExistingFile);
+    config_cmd->add_option("-w,--workers", workers, "The number of worker threads, 0 for one per core [default: from the configuration file].");
+    config_cmd->add_option("-t,--threading", threading, "The threading model: per_worker or shared [default: from the configuration file].");
 
     app.parse(argc, argv);
 
+    nlohmann::json jcfg;
+    if (config_cmd->parsed())
+    {
+      jcfg = load_config(config_path);
+      if (config_cmd->count("--workers") == 0)
+        workers = jcfg.value("workers", workers);
+      if (config_cmd->count("--threading") == 0)
+        threading = jcfg.value("threading", threading);
+    }
+
     // http server
-    asio::io_context ioc;
+    io_context_pool pool(workers, threading_model_from_string(threading));
+    spdlog::info("Running {} worker thread(s) on {} io_context(s), {} backend", pool.threads(), pool.size(), f16::io_backend);
 
     std::vector<std::unique_ptr<http_server>> server_set;
 
     if (serve_cmd->parsed())
     {
-      build_simple_server(ioc, server_set, root_doc, bind_address, port);
+      build_simple_server(pool, server_set, root_doc, bind_address, port);
     }
     else if (config_cmd->parsed())
     {
-      build_advanced_server(ioc, server_set, config_path);
+      build_advanced_server(pool, server_set, jcfg);
     }
     else
     {
@@ -237,30 +331,21 @@ int main(int argc, const char** argv)
     // Register to handle the signals that indicate when the app should exit.
     // It is safe to register for the same signal multiple times in a program,
     // provided all registration for the specified signal is made through Asio.
-    asio::signal_set signals_(ioc);
+    asio::signal_set signals_(pool[0]);
     signals_.add(SIGINT);
     signals_.add(SIGTERM);
 #if defined(SIGQUIT)
     signals_.add(SIGQUIT);
 #endif // defined(SIGQUIT)
-    signals_.async_wait([&ioc](std::error_code /*ec*/, int /*signo*/) { ioc.stop(); });
+    signals_.async_wait([&pool](std::error_code /*ec*/, int /*signo*/) { pool.stop(); });
 
     //  start app
 
     spdlog::info("Start application");
 
-    while (true)
-    {
-      try
-      {
-        ioc.run();
-        break; // run() exited normally
-      }
-      catch (const std::exception& e)
-      {
-        fmt::print(stderr, "Exception caugth in io_context scheduler: {}", e.what());
-      }
-    }
+    pool.run([](const std::exception& e) {
+      fmt::print(stderr, "Exception caugth in io_context scheduler: {}", e.what());
+    });
 
     spdlog::info("Gracefully exit application");
   }
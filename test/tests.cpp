@@ -3,16 +3,33 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
 
+#include "body_parser.hpp"
+#include "connection_manager.hpp"
+#include "connection_pool.hpp"
 #include "dynamic_content.hpp"
+#include "http_server.hpp"
+#include "io_context_pool.hpp"
 #include "http_request.hpp"
 #include "mime_types.hpp"
 #include "path_router.hpp"
+#include "query_string.hpp"
 #include "reply.hpp"
 #include "request_parser.hpp"
+#include "route_pattern.hpp"
+#include "route_tree.hpp"
 #include "string.hpp"
+#include "timer_wheel.hpp"
 #include "url.hpp"
 #include "request.hpp"
+#include "worker_pool.hpp"
 #include <catch2/catch.hpp>
+#include <atomic>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
 
 using namespace f16::http::server;
 
@@ -209,7 +226,7 @@ TEST_CASE("reply converts to buffer", "[reply]")
 
   REQUIRE(buffers.size() == 11);
 
-  CheckEqual(buffers[0], "HTTP/1.0 200 OK\r\n");
+  CheckEqual(buffers[0], "HTTP/1.1 200 OK\r\n");
 
   CheckEqual(buffers[1], "Content-Length");
   CheckEqual(buffers[2], ": ");
@@ -244,6 +261,439 @@ TEST_CASE("parser works properly", "[request_parser]") // NOLINT
   CHECK(req.headers[0].value == "en-us");
 }
 
+TEST_CASE("parser gives the same result however the input is split", "[request_parser]") // NOLINT
+{
+  const std::string long_value(100, 'v');
+  const std::vector<std::string> inputs{
+    "GET /a/very/long/path/to/check/the/simd/scanning?with=query&params=1 HTTP/1.1\r\n"
+    "Host: localhost\r\nUser-Agent: " + long_value + "\r\nX-Empty: \r\n\r\nGET / HTTP/1.1\r\n\r\n",
+    "POST /\xc3\xa8\xff HTTP/1.0\r\nX-Value: caf\xc3\xa9 " + long_value + "\r\n\r\n",
+    "GET / HTTP/1.1\r\nX-Folded: obsolete\r\n  line folding\r\n\r\n",
+    "GET /path/with\x01control/chars/after/sixteen/bytes HTTP/1.1\r\n\r\n",
+    "GET / HTTP/1.1\r\nX-Value: " + long_value + "\x7f" + long_value + "\r\n\r\n",
+    "GET / HTTP/1.1\r\nBad\xc3Name: x\r\n\r\n",
+    "GET / HTTP/1.1\r\nX-Tab: a\tb\r\n\r\n",
+    "GET /incomplete/request HTTP/1.1\r\nHost: loc"
+  };
+
+  for (const auto& input : inputs)
+  {
+    CAPTURE(input);
+
+    // the whole input at once: long runs scanned with SIMD
+    request_parser whole;
+    http_request whole_req;
+    const auto whole_result = whole.parse(whole_req, input.data(), input.data() + input.size());
+
+    // the same input, one chunk at a time (one byte at a time goes through the state machine only)
+    for (std::size_t chunk : { std::size_t{1}, std::size_t{7}, std::size_t{40} })
+    {
+      request_parser parser;
+      http_request req;
+      auto result = std::make_tuple(request_parser::indeterminate, input.data());
+      for (std::size_t pos = 0; pos < input.size() && std::get<0>(result) == request_parser::indeterminate; pos += chunk)
+        result = parser.parse(req, input.data() + pos, input.data() + std::min(pos + chunk, input.size()));
+
+      REQUIRE(std::get<0>(result) == std::get<0>(whole_result));
+      CHECK(std::get<1>(result) == std::get<1>(whole_result));
+      CHECK(req.method == whole_req.method);
+      CHECK(req.uri == whole_req.uri);
+      REQUIRE(req.headers.size() == whole_req.headers.size());
+      for (std::size_t i = 0; i < req.headers.size(); ++i)
+      {
+        CHECK(req.headers[i].name == whole_req.headers[i].name);
+        CHECK(req.headers[i].value == whole_req.headers[i].value);
+      }
+    }
+  }
+}
+
+TEST_CASE("the SIMD scan of the parser finds the same bytes as the scalar one", "[request_parser]") // NOLINT
+{
+  CAPTURE(request_parser::simd_scan());
+
+  // the bytes that stop the scan, and some plain ones (the bytes over 127 are plain)
+  const std::string stops{ '\0', '\x01', '\t', '\n', '\r', '\x1f', ' ', '\x7f' };
+  for (const char delim : { ' ', '\r' })
+  {
+    for (std::size_t size : std::initializer_list<std::size_t>{ 15, 16, 17, 31, 32, 33, 47, 64, 65, 100 })
+    {
+      // plain chars, then one stop byte at each offset (and at none)
+      for (std::size_t offset = 0; offset <= size; ++offset)
+      {
+        for (const char stop : stops)
+        {
+          std::string input(size, 'a');
+          for (std::size_t i = 0; i < size; i += 3)
+            input[i] = static_cast<char>(0x80 + i % 0x7f); // NOLINT
+          if (offset < size)
+            input[offset] = stop;
+          // unaligned too: the vector loads don't assume any alignment
+          for (std::size_t skip : { std::size_t{0}, std::size_t{1} })
+          {
+            const char* begin = input.data() + std::min(skip, size);
+            const char* end = input.data() + size;
+            CAPTURE(delim, size, offset, static_cast<int>(stop), skip);
+            REQUIRE(request_parser::find_ctl_or(begin, end, delim) == request_parser::find_ctl_or_scalar(begin, end, delim));
+          }
+        }
+      }
+    }
+  }
+
+  // a control char at each offset of long uri and header value, through the
+  // whole parser: one call scans the runs, one byte at a time never does
+  const std::string long_run(70, 'x');
+  for (std::size_t offset = 0; offset < long_run.size(); ++offset)
+  {
+    std::string uri = "/" + long_run;
+    uri[1 + offset] = '\x01';
+    std::string value = long_run;
+    value[offset] = '\x7f';
+    for (const auto& input : {
+      "GET " + uri + " HTTP/1.1\r\n\r\n",
+      "GET /" + long_run + " HTTP/1.1\r\nX-Value: " + value + "\r\n\r\n" })
+    {
+      CAPTURE(input);
+      request_parser whole;
+      http_request whole_req;
+      const auto whole_result = whole.parse(whole_req, input.data(), input.data() + input.size());
+
+      request_parser bytewise;
+      http_request req;
+      auto result = std::make_tuple(request_parser::indeterminate, input.data());
+      for (std::size_t pos = 0; pos < input.size() && std::get<0>(result) == request_parser::indeterminate; ++pos)
+        result = bytewise.parse(req, input.data() + pos, input.data() + pos + 1);
+
+      CHECK(std::get<0>(whole_result) == request_parser::bad);
+      CHECK(std::get<0>(result) == std::get<0>(whole_result));
+      CHECK(std::get<1>(result) == std::get<1>(whole_result));
+    }
+  }
+}
+
+TEST_CASE("http_request views follow the data when it's moved", "[http_request]") // NOLINT
+{
+  std::string buffer{ "xxxxGET /index.html HTTP/1.1\r\nHost: exam" };
+  buffer.reserve(100); // no reallocations: the views refer to the buffer
+  request_parser parser;
+  http_request req;
+  auto result = parser.parse(req, buffer.data() + 4, buffer.data() + buffer.size());
+  REQUIRE(std::get<0>(result) == request_parser::indeterminate);
+
+  // move the request at the start of the buffer, then go on
+  buffer.erase(0, 4);
+  req.relocate(-4);
+  const std::size_t received = buffer.size();
+  buffer += "ple.com\r\n\r\n";
+  result = parser.parse(req, buffer.data() + received, buffer.data() + buffer.size());
+  REQUIRE(std::get<0>(result) == request_parser::good);
+  CHECK(req.method == "GET");
+  CHECK(req.uri == "/index.html");
+  CHECK(req.get_header("HOST") == "example.com");
+  CHECK(req.method.data() == buffer.data());
+}
+
+TEST_CASE("the parser indexes the known headers", "[http_request]") // NOLINT
+{
+  const std::string data{
+    "POST /upload HTTP/1.1\r\n"
+    "X-Custom: 1\r\n"
+    "HOST: example.com\r\n"
+    "Content-Length: 0\r\n"
+    "host: other.com\r\n"
+    "Range: \r\n"
+    "\r\n" };
+  request_parser parser;
+  http_request req;
+  auto result = parser.parse(req, data.data(), data.data() + data.size());
+  REQUIRE(std::get<0>(result) == request_parser::good);
+
+  CHECK(http_request::find_known_header("Content-LENGTH") == known_header::content_length);
+  CHECK(http_request::find_known_header("x-custom") == known_header::other);
+
+  // the first one wins, as without the index
+  CHECK(req.get_header(known_header::host) == "example.com");
+  CHECK(req.get_header("Host") == "example.com");
+  CHECK(req.get_header(known_header::content_length) == "0");
+  CHECK(req.get_header("x-CUSTOM") == "1");
+  CHECK(req.get_header(known_header::cookie).empty());
+  CHECK(req.get_header("missing").empty());
+  CHECK(req.has_header(known_header::range));
+  CHECK_FALSE(req.has_header(known_header::transfer_encoding));
+
+  // the same answers when the request is built by hand
+  http_request manual;
+  manual.headers.push_back({"Content-Length", "12"});
+  CHECK(manual.has_header(known_header::content_length));
+  CHECK(manual.get_header(known_header::content_length) == "12");
+  CHECK_FALSE(manual.has_header(known_header::host));
+
+  req.clear();
+  CHECK_FALSE(req.has_header(known_header::host));
+}
+
+TEST_CASE("http_request tells if the connection must be kept alive", "[http_request]") // NOLINT
+{
+  http_request req;
+  req.http_version_major = 1;
+
+  SECTION("HTTP/1.1 is persistent by default")
+  {
+    req.http_version_minor = 1;
+    CHECK(req.keep_alive());
+    req.headers.push_back({"Connection", "Close"});
+    CHECK_FALSE(req.keep_alive());
+  }
+
+  SECTION("HTTP/1.0 is persistent only on request")
+  {
+    req.http_version_minor = 0;
+    CHECK_FALSE(req.keep_alive());
+    req.headers.push_back({"Connection", "foo, Keep-Alive"});
+    CHECK(req.keep_alive());
+  }
+}
+
+TEST_CASE("body_parser decodes the request bodies", "[body_parser]") // NOLINT
+{
+  body_parser parser;
+  http_request req;
+  std::string body;
+  auto sink = [&body](const char* data, std::size_t size) { body.append(data, size); };
+
+  // feed the input a byte at a time, as if each byte came with a different read
+  auto parse_bytewise = [&](const std::string& input) {
+    auto result = body_parser::indeterminate;
+    for (std::size_t i = 0; i < input.size() && result == body_parser::indeterminate; ++i)
+    {
+      const char* end = nullptr;
+      std::tie(result, end) = parser.parse(input.data() + i, input.data() + i + 1, sink);
+      CHECK(end == input.data() + i + 1);
+    }
+    return result;
+  };
+
+  SECTION("No body without Content-Length or Transfer-Encoding")
+  {
+    CHECK(parser.start(req, 0) == body_parser::good);
+    req.headers.push_back({"Content-Length", "0"});
+    CHECK(parser.start(req, 0) == body_parser::good);
+  }
+
+  SECTION("Content-Length body")
+  {
+    req.headers.push_back({"content-length", "5"});
+    REQUIRE(parser.start(req, 10) == body_parser::indeterminate);
+    const std::string input{ "helloGET" };
+    const auto result = parser.parse(input.data(), input.data() + input.size(), sink);
+    CHECK(std::get<0>(result) == body_parser::good);
+    CHECK(std::get<1>(result) == input.data() + 5);
+    CHECK(body == "hello");
+    CHECK(parser.size() == 5);
+  }
+
+  SECTION("Chunked body")
+  {
+    req.headers.push_back({"Transfer-Encoding", "Chunked"});
+    REQUIRE(parser.start(req, 0) == body_parser::indeterminate);
+    CHECK(parser.chunked());
+    CHECK(parse_bytewise("5;name=value\r\nhello\r\nA\r\n, world!!!\r\n0\r\nTrailer: x\r\n\r\n") == body_parser::good);
+    CHECK(body == "hello, world!!!");
+  }
+
+  SECTION("Invalid framing")
+  {
+    req.headers.push_back({"Content-Length", "12x"});
+    CHECK(parser.start(req, 0) == body_parser::bad);
+    req.headers = {{"Content-Length", "5"}, {"Content-Length", "6"}};
+    CHECK(parser.start(req, 0) == body_parser::bad);
+    req.headers = {{"Content-Length", "5"}, {"Transfer-Encoding", "chunked"}};
+    CHECK(parser.start(req, 0) == body_parser::bad);
+    req.headers = {{"Transfer-Encoding", "gzip, chunked"}};
+    CHECK(parser.start(req, 0) == body_parser::bad);
+    req.headers = {{"Transfer-Encoding", "gzip"}, {"transfer-encoding", "chunked"}};
+    CHECK(parser.start(req, 0) == body_parser::bad);
+    req.headers = {{"Transfer-Encoding", "chunked"}};
+    REQUIRE(parser.start(req, 0) == body_parser::indeterminate);
+    CHECK(parse_bytewise("5\r\nhelloX") == body_parser::bad);
+  }
+
+  SECTION("Bodies over the maximum size are refused before their data")
+  {
+    req.headers.push_back({"Content-Length", "11"});
+    CHECK(parser.start(req, 10) == body_parser::too_large);
+    req.headers = {{"Transfer-Encoding", "chunked"}};
+    REQUIRE(parser.start(req, 10) == body_parser::indeterminate);
+    CHECK(parse_bytewise("6\r\nhello,\r\n5\r\n") == body_parser::too_large);
+    CHECK(body == "hello,");
+  }
+}
+
+namespace {
+struct pooled_connection
+{
+  pooled_connection(asio::ip::tcp::socket /*socket*/, int& n) : id(++n) {}
+  void reset(asio::ip::tcp::socket /*socket*/) { ++resets; }
+  int id;
+  int resets = 0;
+};
+} // namespace
+
+TEST_CASE("connection_pool recycles the released connections", "[connection_pool]") // NOLINT
+{
+  asio::io_context ioc;
+  int created = 0;
+  connection_pool<pooled_connection> pool(1);
+
+  auto c1 = pool.acquire(asio::ip::tcp::socket(ioc), created);
+  auto c2 = pool.acquire(asio::ip::tcp::socket(ioc), created);
+  CHECK(c1->id == 1);
+  CHECK(c2->id == 2);
+  c1.reset();
+  c2.reset(); // over capacity: deleted
+
+  auto c3 = pool.acquire(asio::ip::tcp::socket(ioc), created);
+  CHECK(c3->id == 1);
+  CHECK(c3->resets == 1);
+  auto c4 = pool.acquire(asio::ip::tcp::socket(ioc), created);
+  CHECK(c4->id == 3);
+
+  CHECK(pool.stats().hits == 1);
+  CHECK(pool.stats().misses == 3);
+
+  SECTION("a connection can outlive its pool")
+  {
+    auto tmp = std::make_unique<connection_pool<pooled_connection>>(1);
+    auto c = tmp->acquire(asio::ip::tcp::socket(ioc), created);
+    tmp.reset();
+    c.reset();
+  }
+}
+
+namespace {
+struct idle_connection : connection
+{
+  void start() override { ++starts; }
+  void stop() override { ++stops; }
+  int starts = 0;
+  int stops = 0;
+};
+} // namespace
+
+TEST_CASE("connection_manager counts the open connections", "[connection_manager]") // NOLINT
+{
+  const std::size_t total = connection_manager::total_size();
+  int stopped = 0;
+  auto c1 = std::make_shared<idle_connection>();
+  auto c2 = std::make_shared<idle_connection>();
+  {
+    connection_manager cm;
+    cm.on_stop([&stopped]() { ++stopped; });
+
+    cm.start(c1);
+    cm.start(c2);
+    CHECK(c1->starts == 1);
+    CHECK(cm.size() == 2);
+    CHECK(connection_manager::total_size() == total + 2);
+
+    cm.stop(c1);
+    cm.stop(c1); // already removed
+    CHECK(c1->stops == 2);
+    CHECK(stopped == 1);
+    CHECK(cm.size() == 1);
+    CHECK(connection_manager::total_size() == total + 1);
+  } // stops the others
+  CHECK(c2->stops == 1);
+  CHECK(connection_manager::total_size() == total);
+}
+
+TEST_CASE("timer_wheel expires the timers in time", "[timer_wheel]") // NOLINT
+{
+  using namespace std::chrono_literals;
+  const auto t0 = timer_wheel::clock::now();
+  timer_wheel wheel(10ms, t0);
+
+  std::vector<int> expired;
+  timer_wheel::timer short_timer(wheel, [&expired]() { expired.push_back(1); });
+  timer_wheel::timer long_timer(wheel, [&expired]() { expired.push_back(2); });
+  timer_wheel::timer very_long_timer(wheel, [&expired]() { expired.push_back(3); });
+
+  short_timer.arm(45ms); // rounded up to 5 ticks
+  long_timer.arm(5s); // 500 ticks: second level
+  very_long_timer.arm(1000s); // 100000 ticks: third level
+  CHECK(wheel.size() == 3);
+
+  wheel.advance(t0 + 40ms);
+  CHECK(expired.empty());
+  wheel.advance(t0 + 50ms);
+  CHECK(expired == std::vector<int>{ 1 });
+
+  wheel.advance(t0 + 4990ms);
+  CHECK(expired.size() == 1);
+  wheel.advance(t0 + 5s);
+  CHECK(expired == std::vector<int>{ 1, 2 });
+
+  wheel.advance(t0 + 999990ms);
+  CHECK(expired.size() == 2);
+  wheel.advance(t0 + 1000s);
+  CHECK(expired == std::vector<int>{ 1, 2, 3 });
+  CHECK(wheel.size() == 0);
+}
+
+TEST_CASE("timer_wheel timers can be cancelled and re-armed", "[timer_wheel]") // NOLINT
+{
+  using namespace std::chrono_literals;
+  const auto t0 = timer_wheel::clock::now();
+  timer_wheel wheel(10ms, t0);
+
+  int expired = 0;
+  timer_wheel::timer t(wheel, [&expired]() { ++expired; });
+
+  t.arm(100ms);
+  const auto generation = t.generation();
+  t.cancel();
+  CHECK(t.generation() != generation);
+  CHECK(wheel.size() == 0);
+  wheel.advance(t0 + 200ms);
+  CHECK(expired == 0);
+
+  t.arm(100ms); // from t0 + 200ms
+  t.arm(3s); // rescheduled
+  CHECK(wheel.size() == 1);
+  wheel.advance(t0 + 400ms);
+  CHECK(expired == 0);
+  wheel.advance(t0 + 3200ms);
+  CHECK(expired == 1);
+
+  {
+    timer_wheel::timer scoped(wheel, [&expired]() { ++expired; });
+    scoped.arm(10ms);
+  } // cancelled by the destructor
+  CHECK(wheel.size() == 0);
+}
+
+TEST_CASE("timer_wheel timers can outlive their wheel", "[timer_wheel]") // NOLINT
+{
+  using namespace std::chrono_literals;
+  int expired = 0;
+  auto wheel = std::make_unique<timer_wheel>(10ms);
+  timer_wheel::timer armed(*wheel, [&expired]() { ++expired; });
+  timer_wheel::timer idle(*wheel, [&expired]() { ++expired; });
+  armed.arm(100ms);
+  CHECK(wheel->size() == 1);
+
+  wheel.reset(); // e.g., the server goes away before its connections
+
+  // the timers are detached: they do nothing, up to their destruction
+  const auto generation = armed.generation();
+  armed.cancel();
+  CHECK(armed.generation() != generation);
+  idle.arm(10ms);
+  armed.arm(10ms);
+  CHECK(expired == 0);
+}
+
 TEST_CASE("path_router routes simple requests", "[path_router]") // NOLINT
 {
   std::vector<std::pair<int, std::string>> calls;
@@ -357,4 +807,983 @@ TEST_CASE("dynamic_content handles request correctly", "[dynamic_content][serve]
     REQUIRE(rep.headers[1].name == "Content-Type");
     REQUIRE(rep.headers[1].value == "text/plain");
   }
-}
\ No newline at end of file
+}
+TEST_CASE("query_string splits and decodes the query when it's read", "[query_string]") // NOLINT
+{
+  const std::string raw = "name=daniele+p&tag=a&&tag=b%26c&flag&%6Bey=x%3Dy&bad=%zz&tag=";
+  const query_string query{ raw };
+
+  CHECK(query.raw() == raw);
+  REQUIRE(query.size() == 7);
+  CHECK(query[0] == query_string::param{ "name", "daniele p" });
+  CHECK(query.get("name") == "daniele p");
+  CHECK(query.get("key") == "x=y"); // the escapes don't split the parameters
+  CHECK(query.contains("flag"));
+  CHECK(query.get("flag").empty());
+  CHECK(query.get("bad") == "%zz"); // malformed escape: as it was received
+  CHECK_FALSE(query.contains("missing"));
+  CHECK(query.get("missing").empty());
+
+  // repeated keys
+  CHECK(query.get("tag").empty()); // the last one wins
+  CHECK(query.get_all("tag") == std::vector<std::string_view>{ "a", "b&c", "" });
+
+  // the values without escapes are views on the query
+  CHECK(query.get("bad").data() == raw.data() + raw.find("%zz"));
+
+  // a copy has its own decoded values
+  request req{ http_request{} };
+  req.querystring = query;
+  const std::string_view copied = req.query("name");
+  CHECK(copied == "daniele p");
+  CHECK(copied.data() != query.get("name").data());
+  CHECK(req.queries("tag").size() == 3);
+
+  CHECK(query_string{}.empty());
+  CHECK(query_string{ "&&" }.empty());
+}
+
+TEST_CASE("route_pattern matches like match_pattern, without allocations", "[route_pattern]") // NOLINT
+{
+  const std::vector<std::string> patterns{
+    "/", "/foo", "/foo/:id", "/foo/:id/bar", "/user/:id/posts/:post", "/file-:name", "/a/:x/:x", "/:1/:2/:3/:4/:5/:6/:7/:8/:9/:10"
+  };
+  const std::vector<std::string> paths{
+    "/", "/foo", "/foo/", "/foo//", "/foo/12", "/foo/12/", "/foo/12/bar", "/foo//bar", "/user/1/posts/2",
+    "/user/1/posts/", "/file-abc", "/file-", "/a/1/2", "/1/2/3/4/5/6/7/8/9/10", "/1/2/3/4/5/6/7/8/9/10/", "/x"
+  };
+  for (const auto& pattern : patterns)
+  {
+    const route_pattern compiled{ pattern };
+    CHECK(compiled.location() == pattern);
+    for (const auto& path : paths)
+    {
+      CAPTURE(pattern, path);
+      std::unordered_map<std::string, std::string> expected;
+      path_params params;
+      const bool matched = match_pattern(pattern, path, expected);
+      REQUIRE(compiled.match(path, params) == matched);
+      CHECK(compiled.match(path) == matched);
+      if (!matched)
+        continue;
+      REQUIRE(params.size() >= expected.size());
+      for (const auto& [name, value] : expected)
+      {
+        CHECK(params.contains(name));
+        CHECK(params.get(name) == value);
+      }
+    }
+  }
+
+  path_params params;
+  const route_pattern repeated{ "/a/:x/:x" }; // the names are views on the pattern
+  REQUIRE(repeated.match("/a/1/2", params));
+  CHECK(params.get("x") == "2"); // the last one wins
+  CHECK(params.get("y").empty());
+}
+
+TEST_CASE("route_tree finds the same location as trying them all", "[route_tree]") // NOLINT
+{
+  struct location
+  {
+    std::string text;
+    bool prefix;
+  };
+  const std::vector<location> locations{
+    { "/", true }, { "/static", true }, { "/stat/:x", false }, { "/foo/:1", false }, { "/foo/bar/:1", false },
+    { "/bar/:1/:2", false }, { "/bar/foo/aaa/:1", false }, { "/bar/foo/bbb/:1", false },
+    { "/bar/foo/bbb/ccc/:1", false }, { "/foo/bar/aaa/:1", false }, { "/user/:id/profile", false },
+    { "/user/:id/posts/:post", false }, { "/user/me/profile", false }, { "/file-:name", false },
+    { "/api", false }, { "/api/", true }, { "/a/:x", false }, { "/a/:y", false }, { "/b/:x", false },
+  };
+
+  route_tree tree;
+  CHECK(tree.find("/") == route_tree::npos);
+  for (const auto& l : locations)
+    tree.add(l.text, l.prefix);
+  REQUIRE(tree.size() == locations.size());
+
+  // the longest location matching, the first one added among the longest
+  auto linear = [&locations](const std::string& path) {
+    std::size_t best = route_tree::npos;
+    std::unordered_map<std::string, std::string> params;
+    for (std::size_t i = 0; i < locations.size(); ++i)
+    {
+      const auto& l = locations[i];
+      const bool match = l.prefix ? path.rfind(l.text, 0) == 0 : match_pattern(l.text, path, params);
+      if (match && (best == route_tree::npos || l.text.size() > locations[best].text.size()))
+        best = i;
+    }
+    return best;
+  };
+
+  for (const std::string path : { "/", "/static", "/staticfoo", "/stat/1", "/stat", "/foo/x", "/foo/x/", "/foo/bar/x",
+         "/bar/foo/xxx", "/bar/foo/aaa/zzz", "/bar/foo/bbb/ccc/zzz", "/bar/x/y/z", "/user/12/profile",
+         "/user/me/profile", "/user/me/profile/", "/user/12/posts/7", "/user//profile", "/user/12",
+         "/file-abc", "/file-", "/api", "/api/", "/api/x", "/a/1", "/a/", "/a//", "/b/1/", "/nothing" })
+  {
+    CAPTURE(path);
+    CHECK(tree.find(path) == linear(path));
+  }
+}
+
+TEST_CASE("path_router dispatches on the method", "[path_router]") // NOLINT
+{
+  CHECK(http_request::find_method("GET") == http_method::get);
+  CHECK(http_request::find_method("DELETE") == http_method::delete_);
+  CHECK(http_request::find_method("OPTIONS") == http_method::options);
+  CHECK(http_request::find_method("get") == http_method::other);
+  CHECK(http_request::find_method("PROPFIND") == http_method::other);
+
+  path_router router;
+  router.add("/res", get([](const request& /*req*/, std::ostream& os) { os << "get"; }));
+  router.add("/res", dynamic_content("DELETE", [](const request& /*req*/, std::ostream& os) { os << "delete"; }));
+  router.add("/res", dynamic_content("PROPFIND", [](const request& /*req*/, std::ostream& os) { os << "propfind"; }));
+
+  auto serve = [&router](const std::string& data) {
+    request_parser parser;
+    http_request req;
+    REQUIRE(std::get<0>(parser.parse(req, data.data(), data.data() + data.size())) == request_parser::good);
+    reply rep;
+    router(req, rep);
+    return std::make_pair(rep.status, rep.content);
+  };
+
+  CHECK(serve("GET /res HTTP/1.1\r\n\r\n") == std::make_pair(reply::ok, std::string("get")));
+  CHECK(serve("HEAD /res HTTP/1.1\r\n\r\n") == std::make_pair(reply::ok, std::string("get")));
+  CHECK(serve("DELETE /res HTTP/1.1\r\n\r\n") == std::make_pair(reply::ok, std::string("delete")));
+  CHECK(serve("PROPFIND /res HTTP/1.1\r\n\r\n") == std::make_pair(reply::ok, std::string("propfind")));
+  CHECK(serve("POST /res HTTP/1.1\r\n\r\n").first == reply::not_found);
+  CHECK(serve("MKCOL /res HTTP/1.1\r\n\r\n").first == reply::not_found);
+}
+
+TEST_CASE("path_router checks the paths with and without escapes", "[path_router]") // NOLINT
+{
+  path_router router;
+  router.add("/api/users/:id/orders/:order", get([](const request& req, std::ostream& os) { os << req.resource("id") << ' ' << req.resource("order"); }));
+
+  auto serve = [&router](const std::string& uri) {
+    http_request req;
+    req.method = "GET";
+    req.uri = uri;
+    reply rep;
+    router(req, rep);
+    return rep.status == reply::ok ? rep.content : std::to_string(static_cast<int>(rep.status));
+  };
+
+  CHECK(serve("/api/users/1234567/orders/8901") == "1234567 8901");
+  CHECK(serve("/api/users/1234567/orders/8901?x=1") == "1234567 8901");
+  CHECK(serve("/api/users/12%33/orders/a+b") == "123 a b");
+  CHECK(serve("/api/users/../orders/8901") == "400");
+  CHECK(serve("/api/users/%2E%2E/orders/8901") == "400");
+  CHECK(serve("api/users/1/orders/2") == "400");
+  CHECK(serve("/api/users/1/orders/2%") == "400");
+}
+
+TEST_CASE("path_router caches the routes of the paths requested", "[path_router]") // NOLINT
+{
+  path_router router;
+  router.add("/user/:id", get([](const request& req, std::ostream& os) { os << "user " << req.resource("id") << ' ' << req.query("tab"); }));
+  router.add("/user/:id/posts", get([](const request& req, std::ostream& os) { os << "posts " << req.resource("id"); }));
+  router.enable_cache(8);
+
+  auto serve = [&router](const std::string& uri, const std::string& method = "GET") {
+    http_request req;
+    req.method = method;
+    req.uri = uri;
+    reply rep;
+    router(req, rep);
+    return rep.status == reply::ok ? rep.content : std::to_string(static_cast<int>(rep.status));
+  };
+
+  CHECK(serve("/user/1") == "user 1 ");
+  CHECK(serve("/user/1?tab=info") == "user 1 info");
+  CHECK(serve("/user/1?tab=other") == "user 1 other");
+  CHECK(serve("/user/1", "HEAD") == "user 1 ");
+  CHECK(serve("/user/2/posts") == "posts 2");
+  CHECK(serve("/user/2/posts") == "posts 2");
+  CHECK(serve("/user/%31") == "user 1 ");
+  CHECK(serve("/user/1?tab=..") == "400");
+  CHECK(serve("/nothing") == "404");
+  CHECK(serve("/nothing") == "404");
+  // a '?' decoded from the path starts the query: not cached
+  CHECK(serve("/user/1%3Ftab=x") == "user 1 x");
+  CHECK(serve("/user/1%3Ftab=x") == "user 1 x");
+
+  auto stats = router.cache_stats();
+  CHECK(stats.hits == 5);
+  CHECK(stats.misses == 7);
+  CHECK(stats.hit_rate() == Approx(5.0 / 12.0));
+
+  // the cache follows the changes of the routes
+  router.add("/user/:user/posts", get([](const request& req, std::ostream& os) { os << "new posts " << req.resource("user"); }));
+  CHECK(serve("/user/2/posts") == "new posts 2");
+  CHECK(serve("/user/1") == "user 1 ");
+
+  // many paths: the least recently used ones are replaced
+  for (int i = 0; i < 100; ++i)
+    CHECK(serve("/user/x" + std::to_string(i)) == "user x" + std::to_string(i) + ' ');
+  for (int i = 99; i >= 0; --i)
+    CHECK(serve("/user/x" + std::to_string(i)) == "user x" + std::to_string(i) + ' ');
+
+  // each thread has its own cache
+  std::thread other([&serve]() { CHECK(serve("/user/7?tab=a") == "user 7 a"); });
+  other.join();
+  stats = router.cache_stats();
+  CHECK(stats.hits + stats.misses == 12 + 2 + 200 + 1);
+
+  router.enable_cache(0);
+  CHECK(serve("/user/2/posts") == "new posts 2");
+  CHECK(router.cache_stats().hits == 0);
+
+  // the query is checked, and decoded by the handler
+  CHECK(serve("/user/1?tab=%2E.") == "400");
+  CHECK(serve("/user/1?tab=%2") == "400");
+  CHECK(serve("/user/1?tab=a%26b+c") == "user 1 a&b c");
+  CHECK(serve("/user/1%3Ftab=a%26b") == "user 1 a&b");
+}
+
+TEST_CASE("path_router streams the request bodies", "[path_router]") // NOLINT
+{
+  std::string received;
+  path_router router;
+  router.add("/upload/:name", post_stream([&received](const request& req) {
+    const std::string name = req.resource("name");
+    return body_stream{
+      [&received](std::string_view data) { received.append(data); },
+      [&received, name](std::ostream& os) { os << name << ':' << received.size(); }
+    };
+  }));
+  router.add("/form", post([](const request& req, std::ostream& os) { os << req.body(); }));
+
+  http_request req;
+  req.method = "POST";
+
+  req.uri = "/upload/file";
+  auto reader = router.open_body(req);
+  REQUIRE(reader);
+  reader->on_data("abc", 3);
+  reader->on_data("de", 2);
+  reply rep;
+  reader->on_complete(rep);
+  CHECK(received == "abcde");
+  CHECK(rep.content == "file:5");
+
+  // the body of the other resources is collected in the request
+  req.uri = "/form";
+  CHECK_FALSE(router.open_body(req));
+  req.body = "a=1";
+  router(req, rep);
+  CHECK(rep.content == "a=1");
+}
+
+TEST_CASE("dynamic_content streams the response", "[dynamic_content]") // NOLINT
+{
+  auto handler = get([](const request& /*req*/, f16::response_stream& os) {
+    os << "first";
+    auto n = std::make_shared<int>(0);
+    os.stream([n](std::string& chunk) {
+      if (*n == 2)
+        return false;
+      chunk = std::to_string(++*n);
+      return true;
+    });
+  });
+
+  http_request http_req;
+  reply rep;
+  REQUIRE(handler.serve_if_match("/report", "/report", http_req, rep));
+  REQUIRE(rep.chunk_source);
+  CHECK(rep.content == "first");
+  REQUIRE(rep.headers.size() == 1);
+  CHECK(rep.headers[0].name == "Content-Type");
+
+  std::string chunk;
+  const std::function<void()> resume;
+  CHECK(rep.chunk_source(chunk, resume) == reply::chunk_status::more);
+  CHECK(chunk == "1");
+  CHECK(rep.chunk_source(chunk, resume) == reply::chunk_status::more);
+  CHECK(chunk == "2");
+  CHECK(rep.chunk_source(chunk, resume) == reply::chunk_status::done);
+}
+
+TEST_CASE("response_stream formats like a std::ostream", "[response_stream]") // NOLINT
+{
+  f16::response_stream rs;
+  std::ostringstream expected;
+
+  rs << "text " << std::string("string ") << std::string_view("view ") << 'c' << ' ' << 42 << ' ' << -7L << ' ' << 42U << ' ' << 3.5 << ' ' << 1e20 << ' ' << 0.1F << ' ' << true;
+  expected << "text " << std::string("string ") << std::string_view("view ") << 'c' << ' ' << 42 << ' ' << -7L << ' ' << 42U << ' ' << 3.5 << ' ' << 1e20 << ' ' << 0.1F << ' ' << true;
+  CHECK(rs.str() == expected.str());
+
+  // the iostream manipulators are honoured
+  rs << std::hex << 255 << std::dec << ' ' << std::setw(4) << 1 << 2;
+  expected << std::hex << 255 << std::dec << ' ' << std::setw(4) << 1 << 2;
+  CHECK(rs.str() == expected.str());
+
+  // the f16 manipulators set the properties of the response
+  rs << f16::json << f16::bad_request;
+  CHECK(rs.content_type == "application/json");
+  CHECK(rs.status == reply::bad_request);
+
+  const std::string content = rs.take();
+  CHECK(content == expected.str());
+  CHECK(rs.str().empty());
+}
+
+TEST_CASE("worker_pool bounds the jobs waiting for a thread", "[worker_pool]") // NOLINT
+{
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> started;
+  std::atomic<int> done{ 0 };
+  {
+    worker_pool workers(1, 2);
+
+    // the only thread is busy, two jobs can wait
+    REQUIRE(workers.try_post([&started, released, &done]() { started.set_value(); released.wait(); ++done; }));
+    started.get_future().wait();
+    CHECK(workers.try_post([&done]() { ++done; }));
+    CHECK(workers.try_post([&done]() { ++done; }));
+    CHECK(workers.queued() == 2);
+    CHECK_FALSE(workers.try_post([&done]() { ++done; }));
+    CHECK_FALSE(workers.try_reserve());
+
+    release.set_value();
+    while (done != 3)
+      std::this_thread::yield();
+    CHECK(workers.queued() == 0);
+    CHECK(workers.stats().accepted == 3);
+    CHECK(workers.stats().rejected == 2);
+  }
+  CHECK(done == 3);
+}
+
+TEST_CASE("path_router leaves the offloaded resources to the worker threads", "[path_router]") // NOLINT
+{
+  path_router router;
+  router.add("/fast", get([](const request& /*req*/, f16::response_stream& os) { os << "fast"; }));
+  router.add("/slow/:id", get([](const request& req, f16::response_stream& os) { os << "slow " << req.resource("id"); }).offload());
+
+  http_request req;
+  req.method = "GET";
+  reply rep;
+
+  req.uri = "/fast";
+  CHECK(router.serve_inline(req, rep));
+  CHECK(rep.content == "fast");
+
+  req.uri = "/slow/1";
+  rep = reply{};
+  CHECK_FALSE(router.serve_inline(req, rep));
+  CHECK(rep.content.empty());
+  // what the worker thread calls
+  router(req, rep);
+  CHECK(rep.content == "slow 1");
+
+  // the errors are answered at once
+  req.uri = "/missing";
+  CHECK(router.serve_inline(req, rep));
+  CHECK(rep.status == reply::not_found);
+}
+
+TEST_CASE("dynamic_content completes the asynchronous responses", "[dynamic_content]") // NOLINT
+{
+  std::vector<reply> replies;
+  // (shared, rather than captured by reference: gcc 12 -O1 in C++17 loses the writes made through the std::function)
+  auto waiting = std::make_shared<std::vector<f16::async_response>>();
+  auto handler = get_async([waiting](const request& req, f16::async_response res) {
+    if (req.resource("id") == "now")
+    {
+      res << f16::json << R"({"id":")" << req.resource("id") << R"("})";
+      res.send();
+    }
+    else if (req.resource("id") != "forgotten")
+    {
+      waiting->push_back(res);
+    }
+  });
+
+  asio::io_context ioc;
+  const route_pattern location{ "/item/:id" }; // outlives the request, as in path_router
+  http_request http_req;
+  auto serve = [&](const std::string& path) {
+    reply rep;
+    REQUIRE(handler.serve_if_match(location, path, http_req, rep));
+    REQUIRE(rep.async);
+    rep.async->start(ioc.get_executor(), [&replies](reply r) { replies.push_back(std::move(r)); });
+  };
+
+  SECTION("the response is sent by the handler")
+  {
+    serve("/item/now");
+    REQUIRE(replies.size() == 1);
+    CHECK(replies[0].status == reply::ok);
+    CHECK(replies[0].content == R"({"id":"now"})");
+    REQUIRE(replies[0].headers.size() == 2);
+    CHECK(replies[0].headers[1].value == "application/json");
+  }
+
+  SECTION("the response is sent later, and the request is still valid")
+  {
+    serve("/item/later?q=1");
+    REQUIRE(replies.empty());
+    REQUIRE(waiting->size() == 1);
+    const auto& res = waiting->front();
+    res << "later " << res.stream().status;
+    res.send();
+    res.send(); // only the first counts
+    waiting->clear();
+    REQUIRE(replies.size() == 1);
+    CHECK(replies[0].content == "later 200");
+  }
+
+  SECTION("a response never sent is an error")
+  {
+    serve("/item/forgotten");
+    REQUIRE(replies.size() == 1);
+    CHECK(replies[0].status == reply::internal_server_error);
+  }
+}
+
+namespace {
+/// A server on the loopback interface, run by its own thread.
+class loopback_server
+{
+public:
+  loopback_server(const std::string& port, path_router router, const server_settings& settings = {})
+    : server_(ioc_, settings)
+  {
+    server_.set(std::move(router));
+    server_.listen(port, "127.0.0.1");
+    runner_ = std::thread([this]() { ioc_.run(); });
+  }
+
+  loopback_server(const loopback_server&) = delete;
+  loopback_server& operator=(const loopback_server&) = delete;
+
+  ~loopback_server()
+  {
+    ioc_.stop();
+    runner_.join();
+  }
+
+private:
+  asio::io_context ioc_;
+  http_server server_;
+  std::thread runner_;
+};
+
+/// A blocking client sending raw data to a loopback_server.
+class loopback_client
+{
+public:
+  explicit loopback_client(const std::string& port) : socket_(ioc_)
+  {
+    asio::ip::tcp::resolver resolver(ioc_);
+    asio::connect(socket_, resolver.resolve("127.0.0.1", port));
+  }
+
+  void send(std::string_view data) { asio::write(socket_, asio::buffer(data.data(), data.size())); }
+
+  /// Tell the server that nothing more will be sent.
+  void shutdown_send() { socket_.shutdown(asio::ip::tcp::socket::shutdown_send); }
+
+  /// Read the status line and the headers of the next reply.
+  std::string read_head()
+  {
+    const std::size_t size = asio::read_until(socket_, asio::dynamic_buffer(received_), "\r\n\r\n");
+    std::string head = received_.substr(0, size);
+    received_.erase(0, size);
+    return head;
+  }
+
+  /// Read the next reply, with a Content-Length.
+  std::string read_reply()
+  {
+    std::string rep = read_head();
+    const auto pos = rep.find("Content-Length: ");
+    const std::size_t length = pos == std::string::npos ? 0 : std::stoul(rep.substr(pos + 16));
+    if (received_.size() < length)
+      asio::read(socket_, asio::dynamic_buffer(received_), asio::transfer_exactly(length - received_.size()));
+    rep += received_.substr(0, length);
+    received_.erase(0, length);
+    return rep;
+  }
+
+  /// Read all the data until the server closes the connection.
+  std::string read_all()
+  {
+    asio::read(socket_, asio::dynamic_buffer(received_), closed_);
+    return std::exchange(received_, {});
+  }
+
+  /// How the server closed the connection (see read_all).
+  [[nodiscard]] asio::error_code closed() const { return closed_; }
+
+private:
+  asio::io_context ioc_;
+  asio::ip::tcp::socket socket_;
+  std::string received_;
+  asio::error_code closed_;
+};
+} // namespace
+
+TEST_CASE("the replies to HEAD have no content", "[http_server]") // NOLINT
+{
+  path_router router;
+  router.add("/dynamic", get([](const request& /*req*/, f16::response_stream& os) { os << "dynamic"; }));
+  router.add("/streamed", get([](const request& /*req*/, f16::response_stream& os) {
+    os << "first";
+    os.stream([](std::string& chunk) { chunk = "more"; return false; });
+  }));
+  const loopback_server server("7301", std::move(router));
+  loopback_client client("7301");
+
+  // the headers of GET, the client doesn't wait for the content
+  client.send("HEAD /dynamic HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  auto head = client.read_head();
+  CHECK(head.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+  CHECK(head.find("Content-Length: 7\r\n") != std::string::npos);
+
+  client.send("HEAD /streamed HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  head = client.read_head();
+  CHECK(head.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+  CHECK(head.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+
+  client.send("HEAD /missing HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  head = client.read_head();
+  CHECK(head.rfind("HTTP/1.1 404 Not Found\r\n", 0) == 0);
+
+  // the next reply on the same connection follows the headers
+  client.send("GET /dynamic HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+  const auto rest = client.read_all();
+  CHECK(rest.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+  CHECK(rest.size() - rest.find("\r\n\r\n") == 4 + 7);
+  CHECK(rest.substr(rest.size() - 7) == "dynamic");
+}
+
+namespace {
+/// The contents of the replies in data, in order (the replies must have a Content-Length).
+std::vector<std::string> reply_contents(const std::string& data)
+{
+  std::vector<std::string> contents;
+  std::size_t pos = 0;
+  while ((pos = data.find("Content-Length: ", pos)) != std::string::npos)
+  {
+    const std::size_t length = std::stoul(data.substr(pos + 16));
+    pos = data.find("\r\n\r\n", pos) + 4;
+    contents.push_back(data.substr(pos, length));
+    pos += length;
+  }
+  return contents;
+}
+
+path_router echo_router()
+{
+  path_router router;
+  router.add("/echo/:id", get([](const request& req, f16::response_stream& os) { os << "echo " << req.resource("id"); }));
+  return router;
+}
+
+/// The routes streaming a content whose pieces are not ready when they're asked:
+/// "/slow" is resumed by another thread ("1", "2" and the end), "/stuck" never.
+path_router waiting_stream_router()
+{
+  using chunk_status = f16::response_stream::chunk_status;
+  path_router router = echo_router();
+  router.add("/slow", get([](const request& /*req*/, f16::response_stream& os) {
+    os << "first";
+    auto n = std::make_shared<int>(0);
+    auto ready = std::make_shared<std::atomic<bool>>(false);
+    os.stream([n, ready](std::string& chunk, const std::function<void()>& resume) {
+      if (!ready->exchange(false))
+      {
+        std::thread([ready, resume]() {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+          *ready = true;
+          resume();
+        }).detach();
+        return chunk_status::pending;
+      }
+      if (*n == 2)
+        return chunk_status::done;
+      chunk = std::to_string(++*n);
+      return chunk_status::more;
+    });
+  }));
+  router.add("/stuck", get([](const request& /*req*/, f16::response_stream& os) {
+    os << "first";
+    // the producer keeps its resume, as if it was waiting for something
+    auto kept = std::make_shared<std::function<void()>>();
+    os.stream([kept](std::string& /*chunk*/, const std::function<void()>& resume) {
+      *kept = resume;
+      return chunk_status::pending;
+    });
+  }));
+  return router;
+}
+} // namespace
+
+TEST_CASE("the pipelined requests are answered in order", "[http_server]") // NOLINT
+{
+  const loopback_server server("7302", echo_router());
+
+  SECTION("several requests in one read")
+  {
+    loopback_client client("7302");
+    client.send(
+      "GET /echo/1 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+      "GET /echo/2 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+      "GET /missing HTTP/1.1\r\nHost: localhost\r\n\r\n"
+      "GET /echo/3 HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    const auto contents = reply_contents(client.read_all());
+    REQUIRE(contents.size() == 4);
+    CHECK(contents[0] == "echo 1");
+    CHECK(contents[1] == "echo 2");
+    CHECK(contents[2].find("404 Not Found") != std::string::npos);
+    CHECK(contents[3] == "echo 3");
+  }
+
+  SECTION("a request completed by the next read")
+  {
+    loopback_client client("7302");
+    // the start of the second request stays in the buffer, after the first one
+    client.send(
+      "GET /echo/1 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+      "GET /echo/second HTTP/1.1\r\nHo");
+    CHECK(reply_contents(client.read_reply()) == std::vector<std::string>{ "echo 1" });
+    client.send("st: localhost\r\n\r\nGET /echo/thi");
+    CHECK(reply_contents(client.read_reply()) == std::vector<std::string>{ "echo second" });
+    client.send("rd HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    CHECK(reply_contents(client.read_all()) == std::vector<std::string>{ "echo third" });
+  }
+
+  SECTION("the requests after Connection: close are dropped")
+  {
+    loopback_client client("7302");
+    client.send(
+      "GET /echo/1 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+      "GET /echo/2 HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"
+      "GET /echo/3 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    const auto received = client.read_all();
+    CHECK(reply_contents(received) == std::vector<std::string>{ "echo 1", "echo 2" });
+    CHECK(received.find("Connection: close\r\n") != std::string::npos);
+    CHECK(received.find("echo 3") == std::string::npos);
+  }
+}
+
+TEST_CASE("the queued replies go on the wire in order", "[http_server]") // NOLINT
+{
+  path_router router = echo_router();
+  router.add("/count", get([](const request& /*req*/, f16::response_stream& os) {
+    os << "0";
+    auto n = std::make_shared<int>(0);
+    os.stream([n](std::string& chunk) {
+      if (*n == 11)
+        return false;
+      chunk = std::to_string(++*n);
+      return true;
+    });
+  }));
+  const loopback_server server("7305", std::move(router));
+  loopback_client client("7305");
+
+  // all the replies of a read are gathered, up to the streamed one, then its chunks follow
+  client.send(
+    "GET /echo/1 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+    "GET /missing HTTP/1.1\r\nHost: localhost\r\n\r\n"
+    "GET /count HTTP/1.1\r\nHost: localhost\r\n\r\n"
+    "GET /echo/2 HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+  CHECK(client.read_all() ==
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 6\r\n"
+    "Content-Type: text/plain\r\n"
+    "\r\n"
+    "echo 1"
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Length: 85\r\n"
+    "Content-Type: text/html\r\n"
+    "\r\n"
+    "<html><head><title>Not Found</title></head><body><h1>404 Not Found</h1></body></html>"
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "1\r\n0\r\n"
+    "1\r\n1\r\n1\r\n2\r\n1\r\n3\r\n1\r\n4\r\n1\r\n5\r\n1\r\n6\r\n1\r\n7\r\n1\r\n8\r\n1\r\n9\r\n"
+    "2\r\n10\r\n2\r\n11\r\n"
+    "0\r\n\r\n"
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 6\r\n"
+    "Content-Type: text/plain\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "echo 2");
+}
+
+TEST_CASE("the streams wait for their producer to resume", "[http_server]") // NOLINT
+{
+  server_settings settings;
+  settings.handler_timeout = std::chrono::milliseconds(200);
+  std::string port;
+  SECTION("callback connections") { port = "7309"; }
+#if defined(ASIO_HAS_CO_AWAIT)
+  SECTION("coroutine connections")
+  {
+    settings.coroutine_connections = true;
+    port = "7310";
+  }
+#endif
+  const loopback_server server(port, waiting_stream_router(), settings);
+
+  // the pipelined reply follows the end of the stream
+  loopback_client client(port);
+  client.send(
+    "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n"
+    "GET /echo/1 HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+  CHECK(client.read_all() ==
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "5\r\nfirst\r\n"
+    "1\r\n1\r\n1\r\n2\r\n"
+    "0\r\n\r\n"
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 6\r\n"
+    "Content-Type: text/plain\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "echo 1");
+
+  // a producer that doesn't resume within the handler timeout loses the connection
+  loopback_client stuck(port);
+  stuck.send("GET /stuck HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  const auto received = stuck.read_all();
+  CHECK(received.find("5\r\nfirst\r\n") != std::string::npos);
+  CHECK(received.find("0\r\n\r\n") == std::string::npos);
+}
+
+TEST_CASE("the offloaded streams are produced on the worker pool", "[http_server]") // NOLINT
+{
+  std::mutex mutex;
+  std::thread::id io_thread;
+  std::set<std::thread::id> producer_threads;
+  path_router router;
+  router.add("/io", get([&](const request& /*req*/, f16::response_stream& os) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    io_thread = std::this_thread::get_id();
+    os << "io";
+  }));
+  router.add("/report", get([&](const request& /*req*/, f16::response_stream& os) {
+    os << "0";
+    auto n = std::make_shared<int>(0);
+    os.stream([&, n](std::string& chunk) {
+      const std::lock_guard<std::mutex> lock(mutex);
+      producer_threads.insert(std::this_thread::get_id());
+      if (*n == 3)
+        return false;
+      chunk = std::to_string(++*n);
+      return true;
+    });
+  }).offload());
+  server_settings settings;
+  settings.worker_threads = 2;
+  const loopback_server server("7311", std::move(router), settings);
+  loopback_client client("7311");
+
+  client.send(
+    "GET /io HTTP/1.1\r\nHost: localhost\r\n\r\n"
+    "GET /report HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+  const auto received = client.read_all();
+  CHECK(received.find("1\r\n0\r\n1\r\n1\r\n1\r\n2\r\n1\r\n3\r\n0\r\n\r\n") != std::string::npos);
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  CHECK_FALSE(producer_threads.empty());
+  CHECK(producer_threads.count(io_thread) == 0);
+}
+
+TEST_CASE("the clients expecting 100-continue get it before sending the body", "[http_server]") // NOLINT
+{
+  path_router router;
+  router.add("/upload", post([](const request& req, f16::response_stream& os) { os << "got " << req.body(); }));
+  server_settings settings;
+  settings.max_body_size = 10;
+  const loopback_server server("7303", std::move(router), settings);
+  loopback_client client("7303");
+
+  SECTION("the body is read after the interim reply")
+  {
+    client.send("POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\nExpect: 100-continue\r\n\r\n");
+    CHECK(client.read_head() == "HTTP/1.1 100 Continue\r\n\r\n");
+    client.send("hello");
+    CHECK(reply_contents(client.read_reply()) == std::vector<std::string>{ "got hello" });
+
+    // also when the connection is closed after the final reply
+    client.send("POST /upload HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n"
+        "Expect: 100-continue\r\nConnection: close\r\n\r\n");
+    CHECK(client.read_head() == "HTTP/1.1 100 Continue\r\n\r\n");
+    client.send("3\r\nbye\r\n0\r\n\r\n");
+    CHECK(reply_contents(client.read_all()) == std::vector<std::string>{ "got bye" });
+  }
+
+  SECTION("a body too large is refused without waiting for it")
+  {
+    client.send("POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 11\r\nExpect: 100-continue\r\n\r\n");
+    const auto received = client.read_all();
+    CHECK(received.rfind("HTTP/1.1 413 Payload Too Large\r\n", 0) == 0);
+    CHECK(received.find("100 Continue") == std::string::npos);
+  }
+
+  SECTION("no interim reply when the body comes with the headers")
+  {
+    client.send("POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 2\r\nExpect: 100-continue\r\n"
+        "Connection: close\r\n\r\nhi");
+    const auto received = client.read_all();
+    CHECK(received.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    CHECK(reply_contents(received) == std::vector<std::string>{ "got hi" });
+  }
+}
+
+TEST_CASE("the connections over the limit get the 503 reply", "[http_server]") // NOLINT
+{
+  server_settings settings;
+  settings.max_connections = 1;
+  settings.overload = overload_policy::reject;
+  const loopback_server server("7304", echo_router(), settings);
+
+  loopback_client first("7304");
+  first.send("GET /echo/1 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  CHECK(reply_contents(first.read_reply()) == std::vector<std::string>{ "echo 1" });
+
+  // the request is never read, yet the reply arrives before the close
+  loopback_client rejected("7304");
+  rejected.send("GET /echo/2 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  rejected.shutdown_send();
+  const auto received = rejected.read_all();
+  CHECK(received.rfind("HTTP/1.1 503 Service Unavailable\r\n", 0) == 0);
+  CHECK(received.find("Connection: close\r\n") != std::string::npos);
+  CHECK(rejected.closed() == asio::error::eof); // not reset
+}
+
+namespace {
+/// Run one http_server for each io_context of a pool, answering /who with
+/// the index of the server, and send requests from several client threads.
+/// Return the thread ids that ran the handlers of each server.
+std::vector<std::set<std::thread::id>> serve_concurrently(io_context_pool& pool, const std::string& port)
+{
+  server_settings settings;
+  settings.reuse_port = pool.size() > 1;
+  settings.strand_per_connection = pool.size() == 1 && pool.threads() > 1;
+
+  std::mutex mutex;
+  std::vector<std::set<std::thread::id>> threads(pool.size());
+  std::vector<std::unique_ptr<http_server>> servers;
+  for (std::size_t i = 0; i < pool.size(); ++i)
+  {
+    path_router router;
+    router.add("/who", get([i, &mutex, &threads](const request& /*req*/, f16::response_stream& os) {
+      const std::lock_guard<std::mutex> lock(mutex);
+      threads[i].insert(std::this_thread::get_id());
+      os << i;
+    }));
+    auto server = std::make_unique<http_server>(pool[i], settings);
+    server->set(std::move(router));
+    server->listen(port, "127.0.0.1");
+    servers.push_back(std::move(server));
+  }
+  std::thread runner([&pool]() { pool.run(); });
+
+  constexpr std::size_t clients = 8;
+  constexpr std::size_t connections = 4; // for each client
+  constexpr std::size_t requests = 5; // for each connection
+  std::atomic<std::size_t> answered{ 0 };
+  std::vector<std::thread> client_threads;
+  for (std::size_t c = 0; c < clients; ++c)
+    client_threads.emplace_back([&port, &answered, servers = pool.size()]() {
+      for (std::size_t n = 0; n < connections; ++n)
+      {
+        loopback_client client(port);
+        for (std::size_t r = 0; r < requests; ++r)
+        {
+          client.send("GET /who HTTP/1.1\r\nHost: localhost\r\n\r\n");
+          const auto contents = reply_contents(client.read_reply());
+          if (contents.size() == 1 && std::stoul(contents[0]) < servers)
+            ++answered;
+        }
+      }
+    });
+  for (auto& t : client_threads)
+    t.join();
+
+  pool.stop();
+  runner.join();
+  CHECK(answered == clients * connections * requests);
+  return threads;
+}
+} // namespace
+
+TEST_CASE("io_context_pool runs a server for each io_context", "[io_context_pool]") // NOLINT
+{
+  io_context_pool pool(3, threading_model::per_worker);
+  REQUIRE(pool.size() == 3);
+  REQUIRE(pool.threads() == 3);
+
+  const auto threads = serve_concurrently(pool, "7306");
+
+  // the listeners share the port, each server runs on a single thread of its own
+  std::set<std::thread::id> all;
+  std::size_t busy = 0;
+  for (const auto& server_threads : threads)
+  {
+    CHECK(server_threads.size() <= 1);
+    busy += server_threads.size();
+    all.insert(server_threads.begin(), server_threads.end());
+  }
+  CHECK(busy > 1); // 32 connections: all on the same listener is very unlikely
+  CHECK(all.size() == busy);
+}
+
+TEST_CASE("io_context_pool shares an io_context among the threads", "[io_context_pool]") // NOLINT
+{
+  io_context_pool pool(3, threading_model::shared);
+  REQUIRE(pool.size() == 1);
+  REQUIRE(pool.threads() == 3);
+
+  // a single server, with a strand for each connection
+  const auto threads = serve_concurrently(pool, "7307");
+  REQUIRE(threads.size() == 1);
+  CHECK(!threads[0].empty());
+  CHECK(threads[0].size() <= 3);
+}
+
+#if defined(ASIO_HAS_CO_AWAIT)
+TEST_CASE("the coroutine connections serve like the callback ones", "[http_server]") // NOLINT
+{
+  path_router router = echo_router();
+  router.add("/upload", post([](const request& req, f16::response_stream& os) { os << "got " << req.body(); }));
+  server_settings settings;
+  settings.coroutine_connections = true;
+  const loopback_server server("7308", std::move(router), settings);
+  loopback_client client("7308");
+
+  // pipelined, and split between reads
+  client.send(
+    "GET /echo/1 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+    "HEAD /echo/2 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+    "GET /echo/3 HTTP/1.1\r\nHo");
+  CHECK(reply_contents(client.read_reply()) == std::vector<std::string>{ "echo 1" });
+  CHECK(client.read_head().find("Content-Length: 6\r\n") != std::string::npos);
+  client.send("st: localhost\r\n\r\n");
+  CHECK(reply_contents(client.read_reply()) == std::vector<std::string>{ "echo 3" });
+
+  // a body after 100 Continue, then the close
+  client.send("POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 3\r\nExpect: 100-continue\r\n"
+      "Connection: close\r\n\r\n");
+  CHECK(client.read_head() == "HTTP/1.1 100 Continue\r\n\r\n");
+  client.send("abc");
+  CHECK(reply_contents(client.read_all()) == std::vector<std::string>{ "got abc" });
+  CHECK(client.closed() == asio::error::eof);
+}
+#endif